@@ -13,60 +13,137 @@
 //  the License.
 
 #pragma once
-#include <tr1/unordered_map>
-#include <tr1/unordered_set>
+#include "flat_hash_map.h"
 #include <vector>
-#include <deque>
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <utility>
 
 namespace ac {
-	using namespace std::tr1;
+	enum search_status {
+		search_in_progress,
+		search_found,
+		search_failed
+	};
 
-	// Implements A* searching. The graph should follow the graph concept. The
-	// heuristic function shoud be a function object that takes a two nodes and
-	// returns the estimated cost to go from the first to the second. The
-	// heuristic has to be consistent. See:
-	// http://en.wikipedia.org/wiki/Consistent_heuristic
-	template <typename Graph, typename Heuristic, typename OpenList>
-	class astar {
+	// A single A* search that runs a limited number of node expansions at a
+	// time, so that it can be spread over several calls. The graph and open
+	// list follow the same requirements as in astar, and the graph has to
+	// outlive the search. A search that hasn't started holds no memory besides
+	// the object itself.
+	//
+	// The goal tells the search where to start and when to stop. It has:
+	//  - source_count() and source_at(i), the nodes the search starts from, all
+	//    at cost 0
+	//  - connected(graph), false if the search can't succeed. It's called once
+	//    before the search starts so that it doesn't flood a component that
+	//    holds no goal.
+	//  - estimate(n), a consistent estimate of the cost from n to the goal
+	//  - reached(n, parent), called each time a cheaper path to n is found
+	//  - closed(n), called as each node is closed. Returning true ends the
+	//    search, the path goes from a source to n.
+	// See single_target_goal, nearest_target_goal and nearest_source_goal.
+	template <typename Graph, typename Goal, typename OpenList>
+	class basic_astar_search {
 	public:
 		typedef typename Graph::node node_type;
 		typedef typename Graph::node_hash node_hash;
 		typedef typename Graph::cost_type cost_type;
-		typedef typename std::pair<cost_type, cost_type> cost_pair;
-	
+		typedef Goal goal_type;
+
 	public:
-		astar(Graph g, Heuristic h) : _graph(g), _h(h) {
+		// Sets up a search for 'goal'. If 'start' is false the search is idle
+		// and fails until reset() is called.
+		basic_astar_search(Graph& g, const Goal& goal, bool start = true) : _graph(&g), _goal(goal), _status(start ? search_in_progress : search_failed), _started(false), _expansions(0) {
 		}
-		
-		// Performs an A* search starting at 'node' until 'target' is reached or
-		// the search space is exhausted. Returns a vector with the shortest path
-		// between 'source' and 'target'.
-		std::vector<node_type> path(const node_type& source, const node_type& target) {
-			_open.push(source, 0, _h(source, target));
-			while (!_open.empty()) {
+
+		// Starts a new search for 'goal', reusing the memory of the previous one
+		void reset(const Goal& goal) {
+			cleanup();
+			_path.clear();
+			_goal = goal;
+			_status = search_in_progress;
+			_started = false;
+			_expansions = 0;
+		}
+
+		const Goal& goal() const { return _goal; }
+		search_status status() const { return _status; }
+
+		// The number of nodes expanded so far
+		std::size_t expansions() const { return _expansions; }
+
+		// Expands at most 'max_expansions' nodes and returns the new status
+		search_status step(std::size_t max_expansions) {
+			if (_status != search_in_progress)
+				return _status;
+
+			if (!_started) {
+				_started = true;
+
+				// Don't flood the sources' components looking for a goal outside them
+				if (!_goal.connected(*_graph))
+					return finish(search_failed);
+				for (std::size_t i = 0; i < _goal.source_count(); i += 1)
+					_open.push(_goal.source_at(i), 0, _goal.estimate(_goal.source_at(i)));
+			}
+
+			std::size_t expanded = 0;
+			while (expanded < max_expansions) {
+				if (_open.empty())
+					return finish(search_failed);
+
 				typename OpenList::value_type value = _open.pop();
 				node_type& node = value.node;
-				_costs[node] = value.g;
-				
-				if (node == target) {
-					std::vector<node_type> path = build_path(source, target);
-					cleanup();
-					return path;
-				}
-				
-				if (!is_closed(node)) {
-					expand_node(node, target);
-					close(node);
+				if (!close(node, value.g))
+					continue;
+
+				if (_goal.closed(node)) {
+					build_path(node);
+					return finish(search_found);
 				}
+
+				expand_node(node);
+				expanded += 1;
+				_expansions += 1;
 			}
-			
-			// No path found
-			return std::vector<node_type>();
+
+			return _status;
 		}
-	
+
+		// The path from a source to the node that ended the search once the
+		// search is found, empty otherwise
+		const std::vector<node_type>& path() const {
+			return _path;
+		}
+
+		// Exchanges the path with 'p' without copying. Swapping a buffer in
+		// before the search finishes makes it build the path in that buffer's
+		// memory.
+		void swap_path(std::vector<node_type>& p) {
+			_path.swap(p);
+		}
+
+		// Releases all memory not needed by the search in its current state:
+		// spare capacity while it's in progress and everything but the path once
+		// it has finished.
+		void shrink_to_fit() {
+			if (_status != search_in_progress)
+				cleanup();
+			_open.shrink_to_fit();
+			_costs.shrink_to_fit();
+			_parents.shrink_to_fit();
+			if (_path.capacity() > _path.size())
+				std::vector<node_type>(_path).swap(_path);
+		}
+
 	private:
+		search_status finish(search_status status) {
+			_status = status;
+			return status;
+		}
+
 		cost_type cost(const node_type& node) const {
 			typename cost_map::const_iterator it = _costs.find(node);
 			if (it == _costs.end())
@@ -74,63 +151,325 @@ namespace ac {
 			return it->second;
 		}
 		
-		bool is_closed(const node_type& n) {
-			typename closed_set::iterator it = _closed.find(n);
-			return it != _closed.end();
+		// A node is closed once its cost is final, which is when it enters
+		// _costs. Returns false if 'n' was already closed.
+		bool close(const node_type& n, cost_type g) {
+			return _costs.insert(std::make_pair(n, g)).second;
 		}
 		
-		void close(const node_type& n) {
-			_closed.insert(n);
-		}
-		
-		void expand_node(const node_type& n, const node_type& target) {
-			std::vector<node_type> nodes = _graph.adjacent_nodes(n);
+		void expand_node(const node_type& n) {
+			std::vector<node_type> nodes = _graph->adjacent_nodes(n);
 			for (std::size_t i = 0; i < nodes.size(); i += 1) {
 				node_type new_node = nodes[i];
-				cost_type c = _graph.cost(n, new_node);
+				cost_type c = _graph->cost(n, new_node);
 				cost_type g = cost(n) + c;
 				if (g < cost(new_node)) {
-					_open.push(new_node, g, _h(new_node, target));
+					_open.push(new_node, g, _goal.estimate(new_node));
 					_parents[new_node] = n;
+					_goal.reached(new_node, n);
 				}
 			}
 		}
 		
-		std::vector<node_type> build_path(const node_type& source, const node_type& target) const {
-			std::deque<node_type> path;
-			
-			node_type node = target;
-			path.push_front(node);
+		// Writes the path into _path back to front and reverses it in place,
+		// reusing _path's capacity. Sources are the only nodes without a parent.
+		void build_path(node_type node) {
+			_path.clear();
+			_path.push_back(node);
 			
-			while (!(node == source)) {
+			for (;;) {
 				typename node_map::const_iterator it = _parents.find(node);
 				if (it == _parents.end())
-					return std::vector<node_type>(); // no path found!
+					break;
 				node = it->second;
-				path.push_front(node);
+				_path.push_back(node);
 			}
 			
-			return std::vector<node_type>(path.begin(), path.end());
+			std::reverse(_path.begin(), _path.end());
 		}
 	
 		void cleanup() {
 			_open.clear();
-			_closed.clear();
+			_costs.clear();
 			_parents.clear();
 		}
 	
 	private:
-		typedef unordered_set<node_type, node_hash> closed_set;
-		typedef unordered_map<node_type, cost_type, node_hash> cost_map;
-		typedef unordered_map<node_type, node_type, node_hash> node_map;
+		typedef flat_hash_map<node_type, cost_type, node_hash> cost_map;
+		typedef flat_hash_map<node_type, node_type, node_hash> node_map;
 		
 	private:
-		Graph _graph;
-		Heuristic _h;
+		Graph* _graph;
+		Goal _goal;
+		search_status _status;
+		bool _started;
+		std::size_t _expansions;
 		
 		OpenList _open;
-		closed_set _closed;
 		cost_map _costs;
 		node_map _parents;
+		std::vector<node_type> _path;
+	};
+
+	// Goal of a search from 'source' to 'target' guided by a heuristic that
+	// takes two nodes
+	template <typename Graph, typename Heuristic>
+	struct single_target_goal {
+		typedef typename Graph::node node_type;
+		typedef typename Graph::cost_type cost_type;
+
+		Heuristic h;
+		node_type source;
+		node_type target;
+
+		single_target_goal(Heuristic h, const node_type& source, const node_type& target) : h(h), source(source), target(target) {}
+
+		std::size_t source_count() const { return 1; }
+		const node_type& source_at(std::size_t) const { return source; }
+
+		template <typename G>
+		bool connected(G& g) const {
+			return g.connected(source, target);
+		}
+
+		cost_type estimate(const node_type& n) const {
+			return h(n, target);
+		}
+
+		void reached(const node_type&, const node_type&) {}
+
+		bool closed(const node_type& n) const {
+			return n == target;
+		}
+	};
+
+	// Goal of a search from 'source' for the closest node in a target index,
+	// see astar::path_to_any(). 'target' is set to the target found. The index
+	// has to outlive the search.
+	template <typename Graph, typename TargetIndex>
+	struct nearest_target_goal {
+		typedef typename Graph::node node_type;
+		typedef typename Graph::cost_type cost_type;
+
+		const TargetIndex* targets;
+		node_type source;
+		node_type target;
+
+		nearest_target_goal(const TargetIndex& targets, const node_type& source) : targets(&targets), source(source) {}
+
+		std::size_t source_count() const { return 1; }
+		const node_type& source_at(std::size_t) const { return source; }
+
+		// True if at least one target is in the source's component
+		template <typename G>
+		bool connected(G& g) const {
+			for (typename TargetIndex::const_iterator it = targets->begin(); it != targets->end(); ++it) {
+				if (g.connected(source, *it))
+					return true;
+			}
+			return false;
+		}
+
+		cost_type estimate(const node_type& n) const {
+			return targets->distance(n);
+		}
+
+		void reached(const node_type&, const node_type&) {}
+
+		bool closed(const node_type& n) {
+			if (!targets->contains(n))
+				return false;
+			target = n;
+			return true;
+		}
+	};
+
+	// Goal of a Dijkstra search seeded with several sources at once that
+	// assigns each agent the index of its closest source, see
+	// astar::nearest_sources(). The search ends as soon as every agent has
+	// been assigned.
+	template <typename Graph>
+	struct nearest_source_goal {
+		typedef typename Graph::node node_type;
+		typedef typename Graph::node_hash node_hash;
+		typedef typename Graph::cost_type cost_type;
+		typedef flat_hash_map<node_type, std::vector<std::size_t>, node_hash> agent_map;
+
+		std::vector<node_type> sources;
+		std::vector<int> assignments; // -1 for agents no source can reach
+		flat_hash_map<node_type, int, node_hash> origins; // the source each node was reached from
+		agent_map waiting;
+		std::size_t remaining;
+
+		nearest_source_goal(const std::vector<node_type>& sources, const std::vector<node_type>& agents) : sources(sources), assignments(agents.size(), -1), remaining(agents.size()) {
+			for (std::size_t i = 0; i < sources.size(); i += 1)
+				origins.insert(std::make_pair(sources[i], int(i)));
+			for (std::size_t i = 0; i < agents.size(); i += 1)
+				waiting[agents[i]].push_back(i);
+		}
+
+		std::size_t source_count() const { return sources.size(); }
+		const node_type& source_at(std::size_t i) const { return sources[i]; }
+
+		// Gives up on the agents that no source is connected to. False if none
+		// is left.
+		template <typename G>
+		bool connected(G& g) {
+			std::vector<node_type> unreachable;
+			for (typename agent_map::iterator it = waiting.begin(); it != waiting.end(); ++it) {
+				std::size_t i = 0;
+				while (i < sources.size() && !g.connected(sources[i], it->first))
+					i += 1;
+				if (i == sources.size())
+					unreachable.push_back(it->first);
+			}
+
+			for (std::size_t i = 0; i < unreachable.size(); i += 1) {
+				typename agent_map::iterator it = waiting.find(unreachable[i]);
+				remaining -= it->second.size();
+				waiting.erase(it);
+			}
+			return remaining != 0;
+		}
+
+		cost_type estimate(const node_type&) const {
+			return 0;
+		}
+
+		void reached(const node_type& n, const node_type& parent) {
+			// The parent is closed, so its origin is known. Copy it first, adding
+			// 'n' may rehash the map.
+			int origin = origins[parent];
+			origins[n] = origin;
+		}
+
+		bool closed(const node_type& n) {
+			typename agent_map::iterator it = waiting.find(n);
+			if (it == waiting.end())
+				return false;
+			int origin = origins[n];
+			for (std::size_t i = 0; i < it->second.size(); i += 1)
+				assignments[it->second[i]] = origin;
+			remaining -= it->second.size();
+			waiting.erase(it);
+			return remaining == 0;
+		}
+	};
+
+	// A resumable search from 'source' to 'target' guided by a heuristic, the
+	// search that astar runs. The heuristic follows the same requirements as
+	// in astar.
+	template <typename Graph, typename Heuristic, typename OpenList>
+	class astar_search : public basic_astar_search<Graph, single_target_goal<Graph, Heuristic>, OpenList> {
+	public:
+		typedef basic_astar_search<Graph, single_target_goal<Graph, Heuristic>, OpenList> base_type;
+		typedef typename base_type::node_type node_type;
+		typedef typename base_type::goal_type goal_type;
+
+	public:
+		astar_search(Graph& g, Heuristic h) : base_type(g, goal_type(h, node_type(), node_type()), false) {
+		}
+
+		astar_search(Graph& g, Heuristic h, const node_type& source, const node_type& target) : base_type(g, goal_type(h, source, target)) {
+		}
+
+		// Starts a new search from 'source' to 'target', reusing the memory of
+		// the previous one
+		void reset(const node_type& source, const node_type& target) {
+			base_type::reset(goal_type(this->goal().h, source, target));
+		}
+
+		const node_type& source() const { return this->goal().source; }
+		const node_type& target() const { return this->goal().target; }
+	};
+
+	// Implements A* searching. The graph should follow the graph concept, which
+	// includes connected(): it returns false only if there's no path between
+	// two nodes. The heuristic function shoud be a function object that takes a
+	// two nodes and returns the estimated cost to go from the first to the
+	// second. The heuristic has to be consistent. See:
+	// http://en.wikipedia.org/wiki/Consistent_heuristic
+	template <typename Graph, typename Heuristic, typename OpenList>
+	class astar {
+	public:
+		typedef typename Graph::node node_type;
+		typedef typename Graph::node_hash node_hash;
+		typedef typename Graph::cost_type cost_type;
+		typedef typename std::pair<cost_type, cost_type> cost_pair;
+		typedef astar_search<Graph, Heuristic, OpenList> search_type;
+	
+	public:
+		astar(Graph g, Heuristic h) : _graph(g), _h(h), _search(_graph, h) {
+		}
+
+		astar(const astar& a) : _graph(a._graph), _h(a._h), _search(_graph, a._h) {
+		}
+		
+		// Performs an A* search starting at 'node' until 'target' is reached or
+		// the search space is exhausted. Returns a vector with the shortest path
+		// between 'source' and 'target'.
+		std::vector<node_type> path(const node_type& source, const node_type& target) {
+			std::vector<node_type> p;
+			path(source, target, p);
+			return p;
+		}
+
+		// Same as above but writes the path into 'out', replacing its contents
+		// and reusing its memory. Returns false and leaves 'out' empty if there's
+		// no path.
+		bool path(const node_type& source, const node_type& target, std::vector<node_type>& out) {
+			out.clear();
+			_search.reset(source, target);
+			_search.swap_path(out);
+			_search.step(std::numeric_limits<std::size_t>::max());
+			_search.swap_path(out);
+			return _search.status() == search_found;
+		}
+
+		// Searches from 'source' for the closest node in 'targets' and returns
+		// the path to it, or an empty vector if no target can be reached. The
+		// search stops at the first target it closes. 'targets' takes the place
+		// of the heuristic: targets.distance(n) must be a consistent estimate of
+		// the cost from n to the closest target, targets.contains(n) tells if n
+		// is a target and begin() and end() iterate over the targets. See
+		// manhattan_target_index.
+		template <typename TargetIndex>
+		std::vector<node_type> path_to_any(const node_type& source, const TargetIndex& targets) {
+			std::vector<node_type> p;
+			path_to_any(source, targets, p);
+			return p;
+		}
+
+		// Same as above but writes the path into 'out', replacing its contents
+		// and reusing its memory. Returns false and leaves 'out' empty if no
+		// target can be reached.
+		template <typename TargetIndex>
+		bool path_to_any(const node_type& source, const TargetIndex& targets, std::vector<node_type>& out) {
+			out.clear();
+			basic_astar_search<Graph, nearest_target_goal<Graph, TargetIndex>, OpenList> search(_graph, nearest_target_goal<Graph, TargetIndex>(targets, source));
+			search.swap_path(out);
+			search.step(std::numeric_limits<std::size_t>::max());
+			search.swap_path(out);
+			return search.status() == search_found;
+		}
+
+		// Runs one Dijkstra search seeded with all of 'sources' at once and
+		// returns, for each node in 'agents', the index of the closest source or
+		// -1 if no source can reach it. The search stops as soon as every agent
+		// has been assigned; agents that no source is connected to are given up
+		// on before it starts.
+		std::vector<int> nearest_sources(const std::vector<node_type>& sources, const std::vector<node_type>& agents) {
+			basic_astar_search<Graph, nearest_source_goal<Graph>, OpenList> search(_graph, nearest_source_goal<Graph>(sources, agents));
+			search.step(std::numeric_limits<std::size_t>::max());
+			return search.goal().assignments;
+		}
+	
+	private:
+		// _search points to this object's _graph
+		astar& operator=(const astar&);
+
+		Graph _graph;
+		Heuristic _h;
+		search_type _search;
 	};
 }
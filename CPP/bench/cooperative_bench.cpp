@@ -0,0 +1,78 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+// Measures the time cooperative_astar takes to plan 1000 agents per tick on a
+// 256x256 grid with 10% random obstacles, when planning gets 0.5 ms per frame
+// through plan_for().
+
+#include "cooperative_astar.h"
+#include "grid_graph.h"
+#include "manhattan_distance.h"
+#include "timer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+	typedef ac::grid_graph::node node;
+
+	const int size = 256;
+	const int agents = 1000;
+	const int window = 16;
+	const int ticks = 10;
+	const double frame_budget = 0.0005;
+}
+
+int main() {
+	std::srand(42);
+	ac::grid_graph g(size, size);
+	for (int i = 0; i < size * size / 10; i += 1)
+		g.obstacle(node(std::rand() % size, std::rand() % size), true);
+
+	ac::cooperative_astar<ac::grid_graph, ac::manhattan_distance> obj(g, ac::manhattan_distance(), window);
+	ac::flat_hash_set<node, ac::grid_graph::node_hash> used;
+	while (obj.agent_count() < agents) {
+		node source(std::rand() % size, std::rand() % size);
+		node target(std::rand() % size, std::rand() % size);
+		if (g.obstacle(source) || g.obstacle(target) || used.count(source))
+			continue;
+		used.insert(source);
+		obj.add_agent(source, target);
+	}
+
+	std::printf("%d agents, %dx%d grid, window %d, %.1f ms per frame\n", agents, size, size, window, frame_budget * 1e3);
+	for (int tick = 0; tick < ticks; tick += 1) {
+		int frames = 0;
+		double elapsed = 0;
+		double longest = 0;
+		bool done = false;
+		while (!done) {
+			double start = ac::detail::seconds();
+			done = obj.plan_for(frame_budget);
+			double frame = ac::detail::seconds() - start;
+			elapsed += frame;
+			longest = std::max(longest, frame);
+			frames += 1;
+		}
+		obj.advance(window / 2);
+
+		int unplanned = 0;
+		for (int i = 0; i < agents; i += 1)
+			unplanned += !obj.planned(i);
+		std::printf("tick %2d: %7.2f ms in %3d frames, longest frame %.3f ms, %d unplanned\n", tick, elapsed * 1e3,
+			frames, longest * 1e3, unplanned);
+	}
+	return 0;
+}
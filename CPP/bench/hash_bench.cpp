@@ -0,0 +1,106 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+// Compares the probe-length distribution and lookup throughput of
+// flat_hash_map and std::tr1::unordered_map on grid nodes, using both the
+// node_hash from grid_graph and the per-coordinate xor hash it replaced.
+
+#include "flat_hash_map.h"
+#include "grid_graph.h"
+#include "timer.h"
+
+#include <tr1/unordered_map>
+#include <cstdio>
+
+namespace {
+	typedef ac::grid_graph::node node;
+
+	struct xor_hash : public std::unary_function<node, std::size_t> {
+		std::size_t operator()(const node& n) const {
+			std::tr1::hash<int> h;
+			return h(n.col) ^ h(n.row);
+		}
+	};
+
+	template <typename Map>
+	void fill(Map& map, int size) {
+		for (int col = 0; col < size; col += 1) {
+			for (int row = 0; row < size; row += 1)
+				map[node(col, row)] = col + row;
+		}
+	}
+
+	template <typename Map>
+	void measure_lookups(const char* name, const Map& map, int size, int rounds) {
+		long sum = 0;
+		double start = ac::detail::seconds();
+		for (int r = 0; r < rounds; r += 1) {
+			for (int col = 0; col < size; col += 1) {
+				for (int row = 0; row < size; row += 1)
+					sum += map.find(node(row, col))->second;
+			}
+		}
+		double elapsed = ac::detail::seconds() - start;
+		double lookups = double(rounds) * size * size;
+		std::printf("%-28s %8.1f Mlookups/s (checksum %ld)\n", name, lookups / elapsed * 1e-6, sum);
+	}
+
+	template <typename Hash>
+	void flat_probe_lengths(const char* name, int size, int rounds) {
+		ac::flat_hash_map<node, int, Hash> map;
+		fill(map, size);
+
+		std::vector<std::size_t> histogram = map.probe_lengths();
+		std::size_t total = 0;
+		for (std::size_t i = 0; i < histogram.size(); i += 1)
+			total += i * histogram[i];
+
+		std::printf("%s, %dx%d nodes: load %.2f, mean probe %.2f, max probe %lu\n", name, size, size, map.load_factor(),
+			double(total) / map.size(), (unsigned long)histogram.size() - 1);
+		for (std::size_t i = 0; i < histogram.size() && i < 8; i += 1)
+			std::printf("  %2lu: %lu\n", (unsigned long)i, (unsigned long)histogram[i]);
+		measure_lookups(name, map, size, rounds);
+	}
+
+	template <typename Hash>
+	void chained_bucket_lengths(const char* name, int size, int rounds) {
+		std::tr1::unordered_map<node, int, Hash> map;
+		fill(map, size);
+
+		std::size_t longest = 0;
+		std::size_t used = 0;
+		for (std::size_t b = 0; b < map.bucket_count(); b += 1) {
+			std::size_t n = map.bucket_size(b);
+			longest = std::max(longest, n);
+			used += n != 0;
+		}
+
+		std::printf("%s, %dx%d nodes: %lu buckets used of %lu, longest chain %lu\n", name, size, size,
+			(unsigned long)used, (unsigned long)map.bucket_count(), (unsigned long)longest);
+		measure_lookups(name, map, size, rounds);
+	}
+}
+
+int main() {
+	// The xor hash only produces 'size' distinct values on a square grid, so
+	// it gets a smaller grid to finish in reasonable time
+	flat_probe_lengths<ac::grid_graph::node_hash>("flat_hash_map node_hash", 128, 200);
+	flat_probe_lengths<ac::grid_graph::node_hash>("flat_hash_map node_hash", 1024, 5);
+	flat_probe_lengths<xor_hash>("flat_hash_map xor_hash", 128, 1);
+	std::printf("\n");
+	chained_bucket_lengths<ac::grid_graph::node_hash>("unordered_map node_hash", 128, 200);
+	chained_bucket_lengths<ac::grid_graph::node_hash>("unordered_map node_hash", 1024, 5);
+	chained_bucket_lengths<xor_hash>("unordered_map xor_hash", 128, 1);
+	return 0;
+}
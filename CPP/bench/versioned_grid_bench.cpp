@@ -0,0 +1,93 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+// Measures versioned_grid_graph update throughput on its own and while 16
+// threads run astar queries on snapshots.
+
+#include "astar.h"
+#include "bimap_open_list.h"
+#include "manhattan_distance.h"
+#include "timer.h"
+#include "versioned_grid_graph.h"
+
+#include <boost/atomic.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <cstdio>
+
+namespace {
+	typedef ac::versioned_grid_graph::node node;
+	typedef ac::versioned_grid_graph::snapshot snapshot;
+	typedef ac::bimap_open_list<node, ac::grid_graph::node_hash, ac::grid_graph::cost_type> open_list;
+
+	const int size = 256;
+	const int query_threads = 16;
+	const double duration = 2;
+
+	// Simple per-thread generator, std::rand isn't thread safe
+	unsigned next(unsigned& seed) {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) & 0x7fff;
+	}
+
+	void query(const ac::versioned_grid_graph& g, unsigned seed, boost::atomic<bool>& done, boost::atomic<long>& queries) {
+		while (!done.load()) {
+			snapshot s = g.read();
+			ac::astar<snapshot, ac::manhattan_distance, open_list> obj(s, ac::manhattan_distance());
+			node source(next(seed) % size, next(seed) % size);
+			node target(next(seed) % size, next(seed) % size);
+			obj.path(source, target);
+			queries.fetch_add(1);
+		}
+	}
+
+	long update(ac::versioned_grid_graph& g, unsigned seed) {
+		long updates = 0;
+		double end = ac::detail::seconds() + duration;
+		while (ac::detail::seconds() < end) {
+			node n(next(seed) % size, next(seed) % size);
+			g.obstacle(n, next(seed) % 10 == 0);
+			updates += 1;
+		}
+		return updates;
+	}
+}
+
+int main() {
+	ac::versioned_grid_graph g(size, size);
+	unsigned seed = 42;
+	for (int i = 0; i < size * size / 10; i += 1)
+		g.obstacle(node(next(seed) % size, next(seed) % size), true);
+
+	long updates = update(g, 1);
+	std::printf("%dx%d grid, no readers: %.0f updates/s\n", size, size, updates / duration);
+
+	boost::atomic<bool> done(false);
+	boost::atomic<long> queries(0);
+	boost::thread_group readers;
+	for (int i = 0; i < query_threads; i += 1)
+		readers.create_thread(boost::bind(&query, boost::cref(g), i + 1, boost::ref(done), boost::ref(queries)));
+
+	updates = update(g, 2);
+	std::size_t retired = g.retired_count();
+	done.store(true);
+	readers.join_all();
+
+	std::printf("%dx%d grid, %d query threads: %.0f updates/s, %.0f queries/s\n",
+		size, size, query_threads, updates / duration, queries.load() / duration);
+	g.obstacle(node(0, 0), false);
+	std::printf("versions awaiting reclamation: %lu with readers, %lu after they finish\n",
+		(unsigned long)retired, (unsigned long)g.retired_count());
+	return 0;
+}
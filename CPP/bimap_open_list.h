@@ -62,6 +62,11 @@ namespace ac {
 			_bimap.clear();
 		}
 		
+		// Releases spare hash buckets
+		void shrink_to_fit() {
+			_bimap.right.rehash(0);
+		}
+		
 		CostType currentCost(const Node& node) const { // aka g
 			typename bimap_type::right_const_iterator it = _bimap.right.find(node);
 			if (it == _bimap.right.end())
@@ -84,9 +89,13 @@ namespace ac {
 		}
 	
 	private:
+		// Orders by f, breaking ties in favor of the larger g (the node closer
+		// to the goal) so that searches don't expand every node of equal f.
 		struct cost_pair_compare : public std::binary_function<cost_pair, cost_pair, bool> {
 			bool operator()(const cost_pair& cp1, const cost_pair& cp2) const {
-				return cp1.first + cp1.second < cp2.first + cp2.second;
+				CostType f1 = cp1.first + cp1.second;
+				CostType f2 = cp2.first + cp2.second;
+				return f1 < f2 || (f1 == f2 && cp1.first > cp2.first);
 			}
 		};
 	
@@ -0,0 +1,179 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#pragma once
+#include "grid_graph.h"
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace ac {
+	// A path on a grid graph stored as its first node followed by runs of
+	// moves in the same direction. Each run is one byte: the low 2 bits are
+	// the direction, in the order of grid_graph::adjacent_nodes (left, up,
+	// right, down), and the high 6 bits are the run length minus one. Runs
+	// longer than 64 moves take several bytes.
+	//
+	// The nodes are decoded on the fly by const_iterator, the full node vector
+	// never has to exist. start() and runs() are all that's needed to rebuild
+	// the path elsewhere, e.g. after sending it over the network.
+	class compact_path {
+	public:
+		typedef grid_graph::node node;
+
+		class const_iterator {
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef node value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const node* pointer;
+			typedef const node& reference;
+
+			const_iterator() : _runs(0), _run(0), _moves(0), _remaining(0) {}
+
+			const node& operator*() const { return _node; }
+			const node* operator->() const { return &_node; }
+
+			const_iterator& operator++() {
+				_remaining -= 1;
+				if (_remaining == 0)
+					return *this;
+
+				if (_moves == run_length((*_runs)[_run])) {
+					_run += 1;
+					_moves = 0;
+				}
+				move(_node, (*_runs)[_run] & direction_mask);
+				_moves += 1;
+				return *this;
+			}
+
+			const_iterator operator++(int) {
+				const_iterator it = *this;
+				++*this;
+				return it;
+			}
+
+			bool operator==(const const_iterator& it) const { return _remaining == it._remaining; }
+			bool operator!=(const const_iterator& it) const { return _remaining != it._remaining; }
+
+		private:
+			friend class compact_path;
+			const_iterator(const std::vector<unsigned char>* runs, const node& start, std::size_t size) : _runs(runs), _node(start), _run(0), _moves(0), _remaining(size) {}
+
+			const std::vector<unsigned char>* _runs;
+			node _node;
+			std::size_t _run;
+			int _moves; // moves taken in the current run
+			std::size_t _remaining; // nodes left, including the current one
+		};
+
+	public:
+		compact_path() : _size(0) {}
+
+		// Rebuilds a path from the values of start() and runs()
+		compact_path(const node& start, const std::vector<unsigned char>& runs) : _start(start), _runs(runs), _size(1) {
+			for (std::size_t i = 0; i < _runs.size(); i += 1)
+				_size += run_length(_runs[i]);
+		}
+
+		// Encodes the nodes in [first, last). Throws std::invalid_argument if two
+		// consecutive nodes aren't adjacent.
+		template <typename Iterator>
+		compact_path(Iterator first, Iterator last) : _size(0) {
+			assign(first, last);
+		}
+
+		// Replaces the path with the nodes in [first, last), reusing memory
+		template <typename Iterator>
+		void assign(Iterator first, Iterator last) {
+			_runs.clear();
+			_size = 0;
+			if (first == last)
+				return;
+
+			node previous = *first;
+			_start = previous;
+			_size = 1;
+			for (++first; first != last; ++first) {
+				node n = *first;
+				unsigned char d = direction(previous, n);
+				if (!_runs.empty() && (_runs.back() & direction_mask) == d && run_length(_runs.back()) < max_run)
+					_runs.back() += 1 << direction_bits;
+				else
+					_runs.push_back(d);
+				previous = n;
+				_size += 1;
+			}
+		}
+
+		const_iterator begin() const { return const_iterator(&_runs, _start, _size); }
+		const_iterator end() const { return const_iterator(); }
+
+		// The number of nodes in the path
+		std::size_t size() const { return _size; }
+		bool empty() const { return _size == 0; }
+
+		// The first node, undefined if the path is empty
+		const node& start() const { return _start; }
+
+		// The encoded moves, one byte per run
+		const std::vector<unsigned char>& runs() const { return _runs; }
+
+		// Appends all the nodes to 'out'
+		void decode(std::vector<node>& out) const {
+			out.reserve(out.size() + _size);
+			for (const_iterator it = begin(); it != end(); ++it)
+				out.push_back(*it);
+		}
+
+	private:
+		static const int direction_bits = 2;
+		static const unsigned char direction_mask = 3;
+		static const int max_run = 64;
+
+		static int run_length(unsigned char run) {
+			return (run >> direction_bits) + 1;
+		}
+
+		static unsigned char direction(const node& from, const node& to) {
+			int dc = to.col - from.col;
+			int dr = to.row - from.row;
+			if (dc == -1 && dr == 0)
+				return 0;
+			if (dc == 0 && dr == -1)
+				return 1;
+			if (dc == 1 && dr == 0)
+				return 2;
+			if (dc == 0 && dr == 1)
+				return 3;
+			throw std::invalid_argument("compact_path nodes have to be adjacent");
+		}
+
+		static void move(node& n, unsigned char direction) {
+			switch (direction) {
+				case 0: n.col -= 1; break;
+				case 1: n.row -= 1; break;
+				case 2: n.col += 1; break;
+				case 3: n.row += 1; break;
+			}
+		}
+
+	private:
+		node _start;
+		std::vector<unsigned char> _runs;
+		std::size_t _size;
+	};
+}
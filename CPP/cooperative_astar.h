@@ -0,0 +1,470 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#pragma once
+#include "flat_hash_map.h"
+#include "heap_open_list.h"
+#include "timer.h"
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace ac {
+	// Records which agent occupies each node at each timestep. Agents are
+	// identified by non-negative integers.
+	template <typename Node, typename NodeHash>
+	class reservation_table {
+	public:
+		static const int none = -1;
+
+	public:
+		// Returns the agent occupying 'n' at time 't', or 'none'
+		int owner(const Node& n, int t) const {
+			typename owner_map::const_iterator it = _owners.find(key(n, t));
+			if (it == _owners.end())
+				return none;
+			return it->second;
+		}
+
+		// Returns true if an agent other than 'agent' occupies 'n' at time 't'
+		bool reserved(const Node& n, int t, int agent) const {
+			int o = owner(n, t);
+			return o != none && o != agent;
+		}
+
+		// Returns true if 'agent' can move from 'from' at time 't' to 'to' at
+		// time 't + 1' without entering a reserved node or swapping places with
+		// another agent.
+		bool can_move(int agent, const Node& from, const Node& to, int t) const {
+			if (reserved(to, t + 1, agent))
+				return false;
+			if (from == to)
+				return true;
+			int other = owner(to, t);
+			return other == none || other == agent || owner(from, t + 1) != other;
+		}
+
+		// Reserves 'n' at time 't' for 'agent', replacing any previous owner
+		void reserve(const Node& n, int t, int agent) {
+			_owners[key(n, t)] = agent;
+		}
+
+		void clear() {
+			_owners.clear();
+		}
+
+		std::size_t size() const {
+			return _owners.size();
+		}
+
+	private:
+		struct key {
+			Node node;
+			int time;
+			key() : node(), time() {}
+			key(const Node& n, int t) : node(n), time(t) {}
+			bool operator==(const key& k) const {
+				return time == k.time && node == k.node;
+			}
+		};
+
+		struct key_hash : public std::unary_function<key, std::size_t> {
+			std::size_t operator()(const key& k) const {
+				NodeHash h;
+				return h(k.node) ^ static_cast<std::size_t>(k.time) * static_cast<std::size_t>(0x9e3779b97f4a7c15ULL);
+			}
+		};
+
+		typedef flat_hash_map<key, int, key_hash> owner_map;
+
+	private:
+		owner_map _owners;
+	};
+
+	template <typename Node, typename NodeHash>
+	const int reservation_table<Node, NodeHash>::none;
+
+	// Exact distance from any node to a fixed goal, computed by an A* search
+	// that runs backward from the goal towards 'origin' and is resumed whenever
+	// a node it hasn't closed yet is queried. Requires an undirected graph and a
+	// consistent heuristic. See Silver, "Cooperative Pathfinding" (2005).
+	//
+	// Proving the distance of a node off the shortest path can take many
+	// expansions, so queries can also be given an expansion budget and settle
+	// for a lower bound when it runs out.
+	template <typename Graph, typename Heuristic, template <typename, typename, typename> class OpenList = heap_open_list>
+	class true_distance {
+	public:
+		typedef typename Graph::node node_type;
+		typedef typename Graph::node_hash node_hash;
+		typedef typename Graph::cost_type cost_type;
+
+	public:
+		true_distance(Graph& g, Heuristic h, const node_type& goal, const node_type& origin) : _graph(&g), _h(h), _goal(goal), _origin(origin), _last_f(0) {
+			_open.push(goal, 0, _h(goal, origin));
+		}
+
+		// Returns the cost of the shortest path from 'n' to the goal, or the
+		// maximum cost_type value if the goal can't be reached.
+		cost_type operator()(const node_type& n) {
+			std::size_t budget = std::numeric_limits<std::size_t>::max();
+			return (*this)(n, budget);
+		}
+
+		// Same as above but expands at most 'budget' nodes, and subtracts the
+		// ones it expands. Returns estimate(n) if the budget runs out first.
+		cost_type operator()(const node_type& n, std::size_t& budget) {
+			typename cost_map::const_iterator it = _closed.find(n);
+			if (it != _closed.end())
+				return it->second;
+			resume(n, budget);
+			return estimate(n);
+		}
+
+		// Returns the distance from 'n' to the goal if it's already known and a
+		// lower bound otherwise, without expanding any node. Every node not
+		// closed yet has g + h(n, origin) >= _last_f, which gives a bound that
+		// grows as the search goes on.
+		cost_type estimate(const node_type& n) const {
+			typename cost_map::const_iterator it = _closed.find(n);
+			if (it != _closed.end())
+				return it->second;
+			if (_open.empty())
+				return std::numeric_limits<cost_type>::max();
+			return std::max(_h(n, _goal), _last_f - _h(n, _origin));
+		}
+
+	private:
+		void resume(const node_type& n, std::size_t& budget) {
+			while (!_open.empty() && budget > 0) {
+				typename open_list::value_type value = _open.pop();
+				if (_closed.count(value.node))
+					continue;
+				_closed[value.node] = value.g;
+				_last_f = value.g + value.h;
+				budget -= 1;
+
+				std::vector<node_type> nodes = _graph->adjacent_nodes(value.node);
+				for (std::size_t i = 0; i < nodes.size(); i += 1) {
+					if (_closed.count(nodes[i]))
+						continue;
+					cost_type g = value.g + _graph->cost(value.node, nodes[i]);
+					_open.push(nodes[i], g, _h(nodes[i], _origin));
+				}
+
+				if (value.node == n)
+					return;
+			}
+		}
+
+	private:
+		typedef OpenList<node_type, node_hash, cost_type> open_list;
+		typedef flat_hash_map<node_type, cost_type, node_hash> cost_map;
+
+	private:
+		Graph* _graph;
+		Heuristic _h;
+		node_type _goal;
+		node_type _origin;
+		cost_type _last_f; // f of the last expanded node
+		open_list _open;
+		cost_map _closed;
+	};
+
+	// Windowed Hierarchical Cooperative A* (WHCA*). Agents are planned one after
+	// another in a space-time search over (node, time) states. Each agent
+	// searches 'window' steps ahead, avoiding the nodes reserved by the agents
+	// planned before it, and then reserves its own path. Beyond the window the
+	// remaining cost is estimated with the agent's true_distance to its target.
+	//
+	// Agents can wait in place at each step. Waiting costs 1 unless the agent is
+	// at its target. Call plan() and then advance() some number of steps no
+	// larger than the window, typically half of it, to move the agents along.
+	// plan_for() does the same work in time slices so that it can be spread
+	// over several frames.
+	//
+	// Agents are planned in priority order. An agent that can't find a path
+	// around the agents planned before it moves to the front and the round
+	// starts over. The first agent can always find a path because it only
+	// has to avoid the other agents' current positions.
+	//
+	// Each agent's search may expand at most 'distance_budget' nodes of its
+	// reverse search per plan. Past that it uses lower bounds of the true
+	// distance, which the reverse search tightens in later plans.
+	template <typename Graph, typename Heuristic, template <typename, typename, typename> class OpenList = heap_open_list>
+	class cooperative_astar {
+	public:
+		typedef typename Graph::node node_type;
+		typedef typename Graph::node_hash node_hash;
+		typedef typename Graph::cost_type cost_type;
+
+	public:
+		cooperative_astar(Graph g, Heuristic h, int window, std::size_t distance_budget = 64) : _graph(g), _h(h), _window(window), _distance_budget(distance_budget), _planning(false), _next(0), _restarts(0) {
+		}
+
+		~cooperative_astar() {
+			for (std::size_t i = 0; i < _agents.size(); i += 1)
+				delete _agents[i].distance;
+		}
+
+		// Adds an agent with the lowest priority and returns its id
+		int add_agent(const node_type& source, const node_type& target) {
+			agent a;
+			a.position = source;
+			a.target = target;
+			a.distance = new distance_type(_graph, _h, target, source);
+			a.planned = false;
+			_agents.push_back(a);
+			_order.push_back(static_cast<int>(_agents.size()) - 1);
+			_planning = false;
+			return static_cast<int>(_agents.size()) - 1;
+		}
+
+		std::size_t agent_count() const { return _agents.size(); }
+		int window() const { return _window; }
+
+		const node_type& position(int agent) const { return _agents[agent].position; }
+		const node_type& target(int agent) const { return _agents[agent].target; }
+
+		// Returns the nodes 'agent' will occupy at times 0 to window, as computed
+		// by the last call to plan().
+		const std::vector<node_type>& path(int agent) const { return _agents[agent].path; }
+
+		// Returns false if the last plan couldn't give 'agent' a full window that
+		// avoids every other agent. Its path then ends early, at the last step it
+		// could take safely. Only happens when moving agents to the front of the
+		// order keeps failing.
+		bool planned(int agent) const { return _agents[agent].planned; }
+
+		// Plans the next 'window' steps of every agent
+		void plan() {
+			plan_for(std::numeric_limits<double>::max());
+		}
+
+		// Plans agents until 'seconds' have passed, at least one per call, and
+		// returns true once every agent has been planned. Later calls continue
+		// where the last one stopped. Only call advance() after a round is done.
+		bool plan_for(double seconds) {
+			double deadline = detail::seconds() + seconds;
+			if (!_planning)
+				start_round();
+
+			do {
+				if (_next == _order.size()) {
+					_planning = false;
+					return true;
+				}
+
+				int id = _order[_next];
+				agent& a = _agents[id];
+				search(id, a);
+				if (!a.planned && _next > 0 && _restarts < max_restarts) {
+					// Give it priority and start over
+					_order.erase(_order.begin() + _next);
+					_order.insert(_order.begin(), id);
+					_restarts += 1;
+					restart_round();
+					continue;
+				}
+
+				reserve(id, a);
+				_next += 1;
+			} while (detail::seconds() < deadline);
+
+			if (_next == _order.size()) {
+				_planning = false;
+				return true;
+			}
+			return false;
+		}
+
+		// Moves every agent 'steps' nodes along its planned path
+		void advance(int steps) {
+			for (std::size_t i = 0; i < _agents.size(); i += 1) {
+				agent& a = _agents[i];
+				std::size_t t = std::min<std::size_t>(steps, a.path.size() - 1);
+				a.position = a.path[t];
+			}
+		}
+
+		const reservation_table<node_type, node_hash>& reservations() const {
+			return _reservations;
+		}
+
+	private:
+		struct state {
+			node_type node;
+			int time;
+			state() : node(), time() {}
+			state(const node_type& n, int t) : node(n), time(t) {}
+			bool operator==(const state& s) const {
+				return time == s.time && node == s.node;
+			}
+		};
+
+		struct state_hash : public std::unary_function<state, std::size_t> {
+			std::size_t operator()(const state& s) const {
+				node_hash h;
+				return h(s.node) ^ static_cast<std::size_t>(s.time) * static_cast<std::size_t>(0x9e3779b97f4a7c15ULL);
+			}
+		};
+
+		typedef true_distance<Graph, Heuristic, OpenList> distance_type;
+
+		// Each agent's true_distance points into _graph
+		cooperative_astar(const cooperative_astar&);
+		cooperative_astar& operator=(const cooperative_astar&);
+
+		struct agent {
+			node_type position;
+			node_type target;
+			distance_type* distance;
+			std::vector<node_type> path;
+			bool planned;
+		};
+
+		// Failed agents moved to the front per round before giving up on a
+		// conflict-free plan
+		static const int max_restarts = 8;
+
+	private:
+		void start_round() {
+			_restarts = 0;
+			restart_round();
+			_planning = true;
+		}
+
+		void restart_round() {
+			_next = 0;
+			_reservations.clear();
+			for (std::size_t i = 0; i < _agents.size(); i += 1)
+				_reservations.reserve(_agents[i].position, 0, static_cast<int>(i));
+		}
+
+		void reserve(int id, const agent& a) {
+			for (std::size_t t = 0; t < a.path.size(); t += 1)
+				_reservations.reserve(a.path[t], static_cast<int>(t), id);
+
+			// An agent whose path ends early keeps standing at its last node, at
+			// least let the agents planned after it know
+			for (int t = static_cast<int>(a.path.size()); t <= _window; t += 1) {
+				if (_reservations.owner(a.path.back(), t) == _reservations.none)
+					_reservations.reserve(a.path.back(), t, id);
+			}
+		}
+
+		// Sets the agent's path and whether it covers the whole window
+		void search(int id, agent& a) {
+			distance_type& h = *a.distance;
+			std::size_t budget = _distance_budget;
+
+			_open.clear();
+			_closed.clear();
+			_parents.clear();
+			a.path.clear();
+
+			// An agent that can't reach its target just stays out of the way
+			bool reachable = h(a.position, budget) != std::numeric_limits<cost_type>::max();
+
+			// The furthest state reached, in case no state reaches the window
+			state deepest(a.position, 0);
+			_open.push(deepest, 0, 0);
+
+			while (!_open.empty()) {
+				typename open_list::value_type value = _open.pop();
+				const state& s = value.node;
+				if (_closed.count(s))
+					continue;
+
+				// States are pushed with a lower bound of the remaining cost. The
+				// exact value is only looked up for the states that get popped,
+				// most successors never are.
+				cost_type remaining = reachable ? h(s.node, budget) : 0;
+				if (remaining == std::numeric_limits<cost_type>::max())
+					continue;
+				if (remaining > value.h) {
+					_open.push(s, value.g, remaining);
+					continue;
+				}
+				_closed.insert(s);
+				if (s.time > deepest.time)
+					deepest = s;
+
+				if (s.time == _window) {
+					build_path(a, s);
+					a.planned = true;
+					return;
+				}
+
+				std::vector<node_type> nodes = _graph.adjacent_nodes(s.node);
+				nodes.push_back(s.node);
+				for (std::size_t i = 0; i < nodes.size(); i += 1) {
+					state next(nodes[i], s.time + 1);
+					if (_closed.count(next) || !_reservations.can_move(id, s.node, next.node, s.time))
+						continue;
+
+					cost_type c;
+					if (next.node == s.node)
+						c = s.node == a.target || !reachable ? 0 : 1;
+					else
+						c = _graph.cost(s.node, next.node);
+
+					cost_type g = value.g + c;
+					if (g < _open.currentCost(next)) {
+						_open.push(next, g, reachable ? h.estimate(next.node) : 0);
+						_parents[next] = s;
+					}
+				}
+			}
+
+			// Boxed in: keep the steps that don't run into anyone
+			build_path(a, deepest);
+			a.planned = false;
+		}
+
+		void build_path(agent& a, state s) {
+			a.path.resize(s.time + 1);
+			while (s.time > 0) {
+				a.path[s.time] = s.node;
+				s = _parents[s];
+			}
+			a.path[0] = s.node;
+		}
+
+	private:
+		typedef OpenList<state, state_hash, cost_type> open_list;
+		typedef flat_hash_set<state, state_hash> closed_set;
+		typedef flat_hash_map<state, state, state_hash> state_map;
+
+	private:
+		Graph _graph;
+		Heuristic _h;
+		int _window;
+		std::size_t _distance_budget;
+
+		std::vector<agent> _agents;
+		std::vector<int> _order; // agent ids by priority
+		bool _planning; // a round is in progress
+		std::size_t _next; // position in _order of the next agent to plan
+		int _restarts;
+		reservation_table<node_type, node_hash> _reservations;
+
+		open_list _open;
+		closed_set _closed;
+		state_map _parents;
+	};
+
+	template <typename Graph, typename Heuristic, template <typename, typename, typename> class OpenList>
+	const int cooperative_astar<Graph, Heuristic, OpenList>::max_restarts;
+}
@@ -0,0 +1,313 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#pragma once
+#include <boost/cstdint.hpp>
+#include <tr1/functional>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace ac {
+	namespace detail {
+		template <typename Pair>
+		struct select_first {
+			const typename Pair::first_type& operator()(const Pair& p) const { return p.first; }
+		};
+
+		template <typename T>
+		struct identity {
+			const T& operator()(const T& t) const { return t; }
+		};
+
+		// Open-addressing hash table with Robin Hood linear probing. The control
+		// bytes live in their own array, separate from the slots, so that probing
+		// only touches one byte per slot until a candidate is found. A control
+		// byte of 0 marks an empty slot; any other value is the probe distance of
+		// the slot's element plus one, saturated at 255.
+		template <typename Value, typename Key, typename KeyOf, typename Hash, typename Pred>
+		class flat_table {
+		public:
+			typedef Key key_type;
+			typedef Value value_type;
+			typedef std::size_t size_type;
+
+			template <typename Table, typename Ref, typename Ptr>
+			class basic_iterator {
+			public:
+				typedef std::forward_iterator_tag iterator_category;
+				typedef Value value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef Ptr pointer;
+				typedef Ref reference;
+
+				basic_iterator() : _table(), _index() {}
+				basic_iterator(Table* t, size_type i) : _table(t), _index(i) { skip_empty(); }
+				template <typename T, typename R, typename P>
+				basic_iterator(const basic_iterator<T, R, P>& it) : _table(it._table), _index(it._index) {}
+
+				Ref operator*() const { return _table->_slots[_index]; }
+				Ptr operator->() const { return &_table->_slots[_index]; }
+				basic_iterator& operator++() { _index += 1; skip_empty(); return *this; }
+				basic_iterator operator++(int) { basic_iterator it = *this; ++*this; return it; }
+
+				template <typename T, typename R, typename P>
+				bool operator==(const basic_iterator<T, R, P>& it) const { return _index == it._index; }
+				template <typename T, typename R, typename P>
+				bool operator!=(const basic_iterator<T, R, P>& it) const { return _index != it._index; }
+
+			private:
+				void skip_empty() {
+					while (_index < _table->_ctrl.size() && _table->_ctrl[_index] == 0)
+						_index += 1;
+				}
+
+				template <typename V, typename K, typename KO, typename H, typename P> friend class flat_table;
+				template <typename T, typename R, typename P> friend class basic_iterator;
+				Table* _table;
+				size_type _index;
+			};
+
+			typedef basic_iterator<flat_table, Value&, Value*> iterator;
+			typedef basic_iterator<const flat_table, const Value&, const Value*> const_iterator;
+
+		public:
+			flat_table() : _size(0), _shift(64) {}
+
+			iterator begin() { return iterator(this, 0); }
+			iterator end() { return iterator(this, _ctrl.size()); }
+			const_iterator begin() const { return const_iterator(this, 0); }
+			const_iterator end() const { return const_iterator(this, _ctrl.size()); }
+
+			bool empty() const { return _size == 0; }
+			size_type size() const { return _size; }
+			size_type bucket_count() const { return _ctrl.size(); }
+			float load_factor() const { return _ctrl.empty() ? 0 : float(_size) / _ctrl.size(); }
+
+			iterator find(const Key& key) {
+				return iterator(this, find_index(key));
+			}
+
+			const_iterator find(const Key& key) const {
+				return const_iterator(this, find_index(key));
+			}
+
+			size_type count(const Key& key) const {
+				return find_index(key) == _ctrl.size() ? 0 : 1;
+			}
+
+			std::pair<iterator, bool> insert(const Value& value) {
+				size_type i = find_index(_key_of(value));
+				if (i != _ctrl.size())
+					return std::make_pair(iterator(this, i), false);
+
+				if ((_size + 1) * 8 > _ctrl.size() * 7)
+					rehash(_ctrl.empty() ? 16 : _ctrl.size() * 2);
+
+				i = place(value);
+				_size += 1;
+				return std::make_pair(iterator(this, i), true);
+			}
+
+			// Removes the element at 'it'. Later elements of the same probe run
+			// are shifted back one slot, so all iterators are invalidated.
+			void erase(iterator it) {
+				size_type mask = _ctrl.size() - 1;
+				size_type i = it._index;
+				for (;;) {
+					size_type next = (i + 1) & mask;
+					if (_ctrl[next] <= 1) {
+						_ctrl[i] = 0;
+						_slots[i] = Value();
+						break;
+					}
+					_slots[i] = _slots[next];
+					_ctrl[i] = control_byte(distance(next) - 1);
+					i = next;
+				}
+				_size -= 1;
+			}
+
+			size_type erase(const Key& key) {
+				size_type i = find_index(key);
+				if (i == _ctrl.size())
+					return 0;
+				erase(iterator(this, i));
+				return 1;
+			}
+
+			// Removes all elements but keeps the allocated slots so that the table
+			// can be refilled without reallocating.
+			void clear() {
+				for (size_type i = 0; i < _ctrl.size(); i += 1) {
+					if (_ctrl[i] != 0) {
+						_ctrl[i] = 0;
+						_slots[i] = Value();
+					}
+				}
+				_size = 0;
+			}
+
+			// Resizes the table to at least 'n' slots, rounded up to a power of two.
+			void rehash(size_type n) {
+				size_type capacity = 16;
+				while (capacity < n || capacity * 7 < _size * 8)
+					capacity *= 2;
+
+				std::vector<unsigned char> ctrl(capacity, 0);
+				std::vector<Value> slots(capacity);
+				_ctrl.swap(ctrl);
+				_slots.swap(slots);
+				_shift = 64;
+				for (size_type c = capacity; c > 1; c >>= 1)
+					_shift -= 1;
+				for (size_type i = 0; i < ctrl.size(); i += 1) {
+					if (ctrl[i] != 0)
+						place(slots[i]);
+				}
+			}
+
+			void reserve(size_type n) {
+				rehash(n + n / 7 + 1);
+			}
+
+			// Shrinks the table to the smallest size that fits its elements and
+			// frees it entirely if it's empty
+			void shrink_to_fit() {
+				if (_size == 0) {
+					std::vector<unsigned char>().swap(_ctrl);
+					std::vector<Value>().swap(_slots);
+				} else {
+					rehash(0);
+				}
+			}
+
+			void swap(flat_table& t) {
+				_ctrl.swap(t._ctrl);
+				_slots.swap(t._slots);
+				std::swap(_size, t._size);
+				std::swap(_shift, t._shift);
+			}
+
+			// Returns a histogram of probe lengths: element i is the number of
+			// elements that were found i + 1 slots away from their home slot.
+			std::vector<size_type> probe_lengths() const {
+				std::vector<size_type> histogram;
+				for (size_type i = 0; i < _ctrl.size(); i += 1) {
+					if (_ctrl[i] == 0)
+						continue;
+					size_type d = distance(i);
+					if (histogram.size() < d)
+						histogram.resize(d, 0);
+					histogram[d - 1] += 1;
+				}
+				return histogram;
+			}
+
+		private:
+			// Fibonacci hashing: the multiply spreads every bit of the hash into the
+			// top bits, which become the slot index. Hashes like tr1::hash<int>
+			// are the identity, and masking their low bits would put structured
+			// keys into one long cluster.
+			size_type home(const Key& key) const {
+				return size_type((boost::uint64_t(_hash(key)) * 0x9e3779b97f4a7c15ULL) >> _shift);
+			}
+
+			// Probe distance (one-based) of the element in slot i
+			size_type distance(size_type i) const {
+				if (_ctrl[i] < 255)
+					return _ctrl[i];
+				return ((i - home(_key_of(_slots[i]))) & (_ctrl.size() - 1)) + 1;
+			}
+
+			static unsigned char control_byte(size_type distance) {
+				return distance < 255 ? static_cast<unsigned char>(distance) : 255;
+			}
+
+			size_type find_index(const Key& key) const {
+				if (_size == 0)
+					return _ctrl.size();
+
+				size_type mask = _ctrl.size() - 1;
+				const unsigned char* ctrl = &_ctrl[0];
+				size_type i = home(key);
+				for (size_type d = 1; ; d += 1, i = (i + 1) & mask) {
+					size_type slot_distance = ctrl[i];
+					if (slot_distance == 255 && d >= 255)
+						slot_distance = distance(i);
+					// Empty slots have distance 0, so this also stops at them
+					if (slot_distance < d)
+						return _ctrl.size();
+					if (slot_distance == d && _pred(key, _key_of(_slots[i])))
+						return i;
+				}
+			}
+
+			// Inserts a value known not to be in the table and returns its slot.
+			// Elements closer to their home slot than the value being carried are
+			// displaced ("robbed") and carried forward in its place.
+			size_type place(Value value) {
+				size_type mask = _ctrl.size() - 1;
+				size_type i = home(_key_of(value));
+				size_type result = _ctrl.size();
+				for (size_type d = 1; ; d += 1, i = (i + 1) & mask) {
+					if (_ctrl[i] == 0) {
+						_ctrl[i] = control_byte(d);
+						_slots[i] = value;
+						return result == _ctrl.size() ? i : result;
+					}
+
+					size_type slot_distance = distance(i);
+					if (slot_distance < d) {
+						std::swap(_slots[i], value);
+						_ctrl[i] = control_byte(d);
+						d = slot_distance;
+						if (result == _ctrl.size())
+							result = i;
+					}
+				}
+			}
+
+		private:
+			std::vector<unsigned char> _ctrl;
+			std::vector<Value> _slots;
+			size_type _size;
+			int _shift; // 64 - log2(slot count)
+			Hash _hash;
+			Pred _pred;
+			KeyOf _key_of;
+		};
+	}
+
+	// Open-addressing hash map. Unlike std::tr1::unordered_map, elements are
+	// stored inline in a single array so lookups don't chase pointers. Both
+	// keys and values must be default constructible and assignable, and any
+	// insertion or erasure invalidates iterators.
+	template <typename Key, typename Value, typename Hash = std::tr1::hash<Key>, typename Pred = std::equal_to<Key> >
+	class flat_hash_map : public detail::flat_table<std::pair<Key, Value>, Key, detail::select_first<std::pair<Key, Value> >, Hash, Pred> {
+	public:
+		typedef Value mapped_type;
+
+		Value& operator[](const Key& key) {
+			return this->insert(std::pair<Key, Value>(key, Value())).first->second;
+		}
+	};
+
+	// Open-addressing hash set, see flat_hash_map.
+	template <typename Key, typename Hash = std::tr1::hash<Key>, typename Pred = std::equal_to<Key> >
+	class flat_hash_set : public detail::flat_table<Key, Key, detail::identity<Key>, Hash, Pred> {
+	};
+}
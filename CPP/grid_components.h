@@ -0,0 +1,327 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#pragma once
+#include <boost/bind/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace ac {
+	// Connected components of the free cells of a grid with 4-connectivity,
+	// stored as a union-find forest. Each cell has a label, the forest node it
+	// belongs to. build() labels cell i with node i and the root of each tree
+	// is always the smallest node in it.
+	//
+	// build() splits the grid into bands of rows and runs union-find on each
+	// band in its own thread, then joins the bands along their borders.
+	// Freeing a cell merges its neighbors' components in place. Blocking a cell
+	// with more than one free neighbor can split a component: a breadth-first
+	// search from each free neighbor runs until all but one of them have met or
+	// run out of cells, and the cells of the ones that ran out get a new node.
+	// Only if that takes more than 'max_split_expansions' cells is the forest
+	// marked stale and has to be rebuilt.
+	//
+	// Nodes are 32-bit to keep the forest at 8 bytes per cell (up to 12 after
+	// splits), so grids are limited to 2^31 cells.
+	class grid_components {
+	public:
+		grid_components() : _col_count(0), _row_count(0), _stale(true) {}
+
+		bool stale() const { return _stale; }
+
+		// Rebuilds the forest. 'obstacle' is called as obstacle(col, row) and
+		// 'threads' is the maximum number of threads to use, 0 for one per core.
+		template <typename Obstacle>
+		void build(int col_count, int row_count, Obstacle obstacle, unsigned threads = 0) {
+			_col_count = col_count;
+			_row_count = row_count;
+			std::size_t size = std::size_t(col_count) * row_count;
+			if (size > max_cells)
+				throw std::length_error("grid_components: too many cells");
+			_parents.resize(size);
+			_labels.resize(size);
+			_free.assign(size, 0);
+			_ghosts.assign(size, false);
+			_marks.assign(size, 0);
+
+			if (threads == 0)
+				threads = std::max(1u, boost::thread::hardware_concurrency());
+			unsigned bands = std::max(1u, std::min<unsigned>(threads, row_count / min_band_rows));
+
+			std::vector<int> first_rows;
+			for (unsigned b = 0; b <= bands; b += 1)
+				first_rows.push_back(int(std::size_t(row_count) * b / bands));
+
+			if (bands == 1) {
+				build_band<Obstacle>(this, obstacle, 0, row_count);
+			} else {
+				boost::thread_group group;
+				for (unsigned b = 0; b < bands; b += 1)
+					group.create_thread(boost::bind(&build_band<Obstacle>, this, obstacle, first_rows[b], first_rows[b + 1]));
+				group.join_all();
+			}
+
+			for (unsigned b = 1; b < bands; b += 1) {
+				int row = first_rows[b];
+				for (int col = 0; col < col_count; col += 1)
+					join(index(col, row), index(col, row - 1));
+			}
+
+			// Every parent precedes its child, so one pass in order flattens the forest
+			for (std::size_t i = 0; i < size; i += 1)
+				_parents[i] = _parents[_parents[i]];
+			_stale = false;
+		}
+
+		// Returns true if both cells are free and in the same component. The
+		// forest must not be stale.
+		bool connected(int col1, int row1, int col2, int row2) {
+			std::size_t i1 = index(col1, row1);
+			std::size_t i2 = index(col2, row2);
+			if (!_free[i1] || !_free[i2])
+				return false;
+			return find(_labels[i1]) == find(_labels[i2]);
+		}
+
+		// Updates the forest after the cell at (col, row) became free
+		void freed(int col, int row) {
+			if (_stale)
+				return;
+
+			std::size_t i = index(col, row);
+			if (_ghosts[i]) {
+				// Other cells may still point to its node, resetting it would cut
+				// them off
+				if (!relabel(&i, &i + 1))
+					return;
+				_ghosts[i] = false;
+			} else {
+				_parents[_labels[i]] = _labels[i];
+			}
+
+			_free[i] = 1;
+			if (col > 0)
+				join(i, index(col - 1, row));
+			if (row > 0)
+				join(i, index(col, row - 1));
+			if (col + 1 < _col_count)
+				join(i, index(col + 1, row));
+			if (row + 1 < _row_count)
+				join(i, index(col, row + 1));
+		}
+
+		// Updates the forest after the cell at (col, row) became blocked
+		void blocked(int col, int row) {
+			if (_stale)
+				return;
+
+			// The cell stays in the forest, other cells may point to its node
+			std::size_t i = index(col, row);
+			_free[i] = 0;
+			_ghosts[i] = true;
+
+			std::size_t neighbors[4];
+			std::size_t count = 0;
+			if (col > 0 && _free[i - 1])
+				neighbors[count++] = i - 1;
+			if (row > 0 && _free[i - _col_count])
+				neighbors[count++] = i - _col_count;
+			if (col + 1 < _col_count && _free[i + 1])
+				neighbors[count++] = i + 1;
+			if (row + 1 < _row_count && _free[i + _col_count])
+				neighbors[count++] = i + _col_count;
+
+			// A dead end can't disconnect anything
+			if (count > 1)
+				split(neighbors, count);
+		}
+
+	private:
+		static const int min_band_rows = 64;
+		static const std::size_t max_split_expansions = 16384;
+
+		// The forest can grow to twice the cells, every node has to fit in 32 bits
+		typedef boost::uint32_t node_index;
+		static const std::size_t max_cells = std::size_t(1) << 31;
+
+		template <typename Obstacle>
+		static void build_band(grid_components* c, Obstacle obstacle, int first_row, int end_row) {
+			for (int row = first_row; row < end_row; row += 1) {
+				for (int col = 0; col < c->_col_count; col += 1) {
+					std::size_t i = c->index(col, row);
+					c->_parents[i] = node_index(i);
+					c->_labels[i] = node_index(i);
+					if (obstacle(col, row))
+						continue;
+
+					c->_free[i] = 1;
+					if (col > 0)
+						c->join(i, i - 1);
+					if (row > first_row)
+						c->join(i, i - c->_col_count);
+				}
+			}
+		}
+
+		std::size_t index(int col, int row) const {
+			return std::size_t(row) * _col_count + col;
+		}
+
+		// Finds out which of the free cells 'starts', all in one component
+		// before a cell between them was blocked, are still connected. Each
+		// start grows its own breadth-first search, one cell at a time in turn,
+		// and searches that touch each other are merged. A group of searches that
+		// runs out of cells has found a whole component, which gets a new node.
+		// The last group left keeps the old nodes.
+		void split(const std::size_t* starts, std::size_t count) {
+			std::vector<std::size_t> queues[4];
+			std::size_t heads[4] = {};
+			std::size_t groups[4];
+			bool done[4] = {};
+			std::size_t active = count;
+			for (std::size_t s = 0; s < count; s += 1) {
+				groups[s] = s;
+				_marks[starts[s]] = (unsigned char)(s + 1);
+				queues[s].push_back(starts[s]);
+			}
+
+			std::size_t expansions = 0;
+			while (active > 1 && !_stale) {
+				if (expansions > max_split_expansions) {
+					_stale = true;
+					break;
+				}
+
+				for (std::size_t s = 0; s < count && active > 1; s += 1) {
+					if (done[groups[s]] || heads[s] == queues[s].size())
+						continue;
+
+					std::size_t i = queues[s][heads[s]++];
+					expansions += 1;
+					int col = int(i % _col_count);
+					int row = int(i / _col_count);
+					if (col > 0)
+						visit(i - 1, s, queues, groups, count, active);
+					if (row > 0)
+						visit(i - _col_count, s, queues, groups, count, active);
+					if (col + 1 < _col_count)
+						visit(i + 1, s, queues, groups, count, active);
+					if (row + 1 < _row_count)
+						visit(i + _col_count, s, queues, groups, count, active);
+				}
+
+				for (std::size_t g = 0; g < count && active > 1; g += 1) {
+					if (groups[g] != g || done[g] || !exhausted(g, queues, heads, groups, count))
+						continue;
+
+					std::vector<std::size_t> cells;
+					for (std::size_t s = 0; s < count; s += 1) {
+						if (groups[s] == g)
+							cells.insert(cells.end(), queues[s].begin(), queues[s].end());
+					}
+					if (!relabel(&cells[0], &cells[0] + cells.size()))
+						break;
+					done[g] = true;
+					active -= 1;
+				}
+			}
+
+			for (std::size_t s = 0; s < count; s += 1) {
+				for (std::size_t k = 0; k < queues[s].size(); k += 1)
+					_marks[queues[s][k]] = 0;
+			}
+		}
+
+		// Adds a free cell to search 's' or merges the groups of 's' and the
+		// search that got there first
+		void visit(std::size_t i, std::size_t s, std::vector<std::size_t>* queues, std::size_t* groups, std::size_t count, std::size_t& active) {
+			if (!_free[i])
+				return;
+			if (_marks[i] == 0) {
+				_marks[i] = (unsigned char)(s + 1);
+				queues[s].push_back(i);
+				return;
+			}
+
+			std::size_t g1 = groups[s];
+			std::size_t g2 = groups[_marks[i] - 1];
+			if (g1 == g2)
+				return;
+			std::size_t from = std::max(g1, g2);
+			std::size_t to = std::min(g1, g2);
+			for (std::size_t k = 0; k < count; k += 1) {
+				if (groups[k] == from)
+					groups[k] = to;
+			}
+			active -= 1;
+		}
+
+		static bool exhausted(std::size_t g, const std::vector<std::size_t>* queues, const std::size_t* heads, const std::size_t* groups, std::size_t count) {
+			for (std::size_t s = 0; s < count; s += 1) {
+				if (groups[s] == g && heads[s] != queues[s].size())
+					return false;
+			}
+			return true;
+		}
+
+		// Moves the cells in [first, last) to a new node. The forest grows by
+		// one node each time, past twice the number of cells it is marked stale
+		// instead.
+		bool relabel(const std::size_t* first, const std::size_t* last) {
+			if (_parents.size() >= 2 * _labels.size()) {
+				_stale = true;
+				return false;
+			}
+
+			node_index node = node_index(_parents.size());
+			_parents.push_back(node);
+			for (; first != last; ++first)
+				_labels[*first] = node;
+			return true;
+		}
+
+		node_index find(node_index i) {
+			while (_parents[i] != i) {
+				_parents[i] = _parents[_parents[i]];
+				i = _parents[i];
+			}
+			return i;
+		}
+
+		// Merges the components of two cells if both are free
+		void join(std::size_t i1, std::size_t i2) {
+			if (!_free[i1] || !_free[i2])
+				return;
+			node_index r1 = find(_labels[i1]);
+			node_index r2 = find(_labels[i2]);
+			if (r1 < r2)
+				_parents[r2] = r1;
+			else if (r2 < r1)
+				_parents[r1] = r2;
+		}
+
+	private:
+		int _col_count;
+		int _row_count;
+		bool _stale;
+		std::vector<node_index> _parents; // by node
+		std::vector<node_index> _labels; // the node of each cell
+		std::vector<unsigned char> _free; // not vector<bool>, bands write it concurrently
+		std::vector<bool> _ghosts; // blocked cells whose node other cells may still point to
+		std::vector<unsigned char> _marks; // the split() search that reached each cell, plus one
+	};
+}
@@ -13,9 +13,11 @@
 //  the License.
 
 #pragma once
-#include <tr1/unordered_set>
+#include "grid_components.h"
+#include <boost/cstdint.hpp>
 #include <vector>
 #include <cmath>
+#include <ostream>
 
 namespace ac {
 	class grid_graph {
@@ -32,10 +34,16 @@ namespace ac {
 			}
 		};
 		
+		// Packs both coordinates into 64 bits and mixes them with the splitmix64
+		// finalizer so that every bit of the result depends on every coordinate
+		// bit. Combining per-coordinate hashes with xor maps (a, b) and (b, a) to
+		// the same value and every diagonal node to 0.
 		struct node_hash : public std::unary_function<node, std::size_t> {
 			std::size_t operator()(const node& n) const {
-				std::tr1::hash<int> h;
-				return h(n.col) ^ h(n.row);
+				boost::uint64_t x = boost::uint64_t(boost::uint32_t(n.col)) << 32 | boost::uint32_t(n.row);
+				x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+				x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+				return static_cast<std::size_t>(x ^ (x >> 31));
 			}
 		};
 
@@ -44,7 +52,7 @@ namespace ac {
 		}
 		
 	public:
-		grid_graph(int col_count, int row_count) : _col_count(col_count), _row_count(row_count) {}
+		grid_graph(int col_count, int row_count) : _col_count(col_count), _row_count(row_count), _obstacles(std::size_t(col_count) * row_count, false) {}
 	
 		int row_count() const { return _row_count; }
 		int col_count() const { return _col_count; }
@@ -52,6 +60,7 @@ namespace ac {
 		// Returns a vector of all empty nodes adjacent to n
 		std::vector<node> adjacent_nodes(const node& n) {
 			std::vector<node> nodes;
+			nodes.reserve(4);
 			node new_node = n;
 		
 			new_node.col -= 1;
@@ -81,8 +90,17 @@ namespace ac {
 			return std::abs(n2.col - n1.col) + std::abs(n2.row - n1.row);
 		}
 	
-		// Sets or resets an obstacle
-		void obstacle(const node& n, bool obstacle) { if (obstacle) _obstacles.insert(n); }
+		// Sets or resets an obstacle. Nodes outside the grid are always obstacles.
+		void obstacle(const node& n, bool obstacle) {
+			if (!contains(n) || _obstacles[index(n)] == obstacle)
+				return;
+			_obstacles[index(n)] = obstacle;
+			if (obstacle)
+				_components.blocked(n.col, n.row);
+			else
+				_components.freed(n.col, n.row);
+		}
+
 		bool obstacle(const node& n) const {
 			// Pretend there are obstacles on every node outside the specified width and height
 			if (n.row < 0 || n.row >= _row_count)
@@ -90,12 +108,44 @@ namespace ac {
 			if (n.col < 0 || n.col >= _col_count)
 				return true;
 			
-			return _obstacles.find(n) != _obstacles.end();
+			return _obstacles[index(n)];
+		}
+
+		// Returns false if there is no path between n1 and n2. The connected
+		// components are built on the first call and after an obstacle splits
+		// a component too large to relabel in place.
+		bool connected(const node& n1, const node& n2) {
+			// No search reaches a target inside an obstacle, but don't reject
+			// searches that start inside one
+			if (obstacle(n2))
+				return n1 == n2;
+			if (obstacle(n1))
+				return true;
+
+			if (_components.stale())
+				_components.build(_col_count, _row_count, obstacle_at(*this));
+			return _components.connected(n1.col, n1.row, n2.col, n2.row);
 		}
 	
+	private:
+		struct obstacle_at {
+			const grid_graph* g;
+			obstacle_at(const grid_graph& g) : g(&g) {}
+			bool operator()(int col, int row) const { return g->obstacle(node(col, row)); }
+		};
+
+		bool contains(const node& n) const {
+			return n.col >= 0 && n.col < _col_count && n.row >= 0 && n.row < _row_count;
+		}
+
+		std::size_t index(const node& n) const {
+			return std::size_t(n.row) * _col_count + n.col;
+		}
+
 	private:
 		int _col_count;
 		int _row_count;
-		std::tr1::unordered_set<node, node_hash> _obstacles;
+		std::vector<bool> _obstacles;
+		grid_components _components;
 	};
 }
@@ -0,0 +1,128 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#pragma once
+#include "flat_hash_map.h"
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace ac {
+	// Open list backed by a binary heap in a vector. A cheaper push of a node
+	// that is already open doesn't move the old entry, it adds a new one and
+	// the old one is dropped when it reaches the top. A flat_hash_map keeps the
+	// current costs of every open node. There are no per-node allocations or
+	// tree rebalancing, which makes it much cheaper than bimap_open_list for
+	// searches that push many short-lived states.
+	template <typename Node, typename NodeHash, typename CostType>
+	class heap_open_list {
+	public:
+		struct value_type {
+			Node node;
+			CostType g;
+			CostType h;
+			value_type() : node(), g(std::numeric_limits<CostType>::max()), h(0) {}
+			value_type(const Node& n, const CostType& g, const CostType& h) : node(n), g(g), h(h) {}
+		};
+
+	public:
+		void push(const Node& node, CostType g, CostType h) {
+			std::pair<typename cost_map::iterator, bool> result = _costs.insert(std::make_pair(node, cost_pair(g, h)));
+			if (!result.second) {
+				if (g >= result.first->second.first)
+					return;
+				result.first->second = cost_pair(g, h);
+			}
+			_heap.push_back(value_type(node, g, h));
+			std::push_heap(_heap.begin(), _heap.end(), after);
+			drop_stale();
+		}
+
+		value_type pop() {
+			if (_heap.empty())
+				return value_type();
+
+			value_type value = _heap.front();
+			_costs.erase(value.node);
+			std::pop_heap(_heap.begin(), _heap.end(), after);
+			_heap.pop_back();
+			drop_stale();
+			return value;
+		}
+
+		bool empty() const {
+			return _heap.empty();
+		}
+
+		void clear() {
+			_heap.clear();
+			_costs.clear();
+		}
+
+		void shrink_to_fit() {
+			if (_heap.capacity() > _heap.size())
+				std::vector<value_type>(_heap).swap(_heap);
+			_costs.shrink_to_fit();
+		}
+
+		CostType currentCost(const Node& node) const { // aka g
+			typename cost_map::const_iterator it = _costs.find(node);
+			if (it == _costs.end())
+				return std::numeric_limits<CostType>::max();
+			return it->second.first;
+		}
+
+		CostType costEstimateToGoal(const Node& node) const { // aka h
+			typename cost_map::const_iterator it = _costs.find(node);
+			if (it == _costs.end())
+				return std::numeric_limits<CostType>::max();
+			return it->second.second;
+		}
+
+		CostType totalCostEstimate(const Node& node) const { // aka f
+			typename cost_map::const_iterator it = _costs.find(node);
+			if (it == _costs.end())
+				return std::numeric_limits<CostType>::max();
+			return it->second.first + it->second.second;
+		}
+
+	private:
+		typedef std::pair<CostType, CostType> cost_pair;
+		typedef flat_hash_map<Node, cost_pair, NodeHash> cost_map;
+
+		// Heap order, the reverse of bimap_open_list's: by f, ties go to the
+		// larger g
+		static bool after(const value_type& v1, const value_type& v2) {
+			CostType f1 = v1.g + v1.h;
+			CostType f2 = v2.g + v2.h;
+			return f1 > f2 || (f1 == f2 && v1.g < v2.g);
+		}
+
+		// Keeps the top entry current so that empty() is exact
+		void drop_stale() {
+			while (!_heap.empty()) {
+				typename cost_map::const_iterator it = _costs.find(_heap.front().node);
+				if (it != _costs.end() && it->second.first == _heap.front().g)
+					return;
+				std::pop_heap(_heap.begin(), _heap.end(), after);
+				_heap.pop_back();
+			}
+		}
+
+	private:
+		std::vector<value_type> _heap;
+		cost_map _costs;
+	};
+}
@@ -13,8 +13,9 @@
 //  the License.
 
 #pragma once
+#include "flat_hash_map.h"
 #include <algorithm>
-#include <tr1/unordered_map>
+#include <limits>
 #include <vector>
 
 namespace ac {
@@ -70,6 +71,13 @@ namespace ac {
 			_estimates_to_goal.clear();
 		}
 		
+		// Releases spare capacity
+		void shrink_to_fit() {
+			std::vector<Node>(_open).swap(_open);
+			_current_costs.shrink_to_fit();
+			_estimates_to_goal.shrink_to_fit();
+		}
+		
 		CostType currentCost(const Node& node) const {
 			typename cost_map::const_iterator it = _current_costs.find(node);
 			if (it == _current_costs.end())
@@ -93,14 +101,17 @@ namespace ac {
 		}
 		
 	private:
-		typedef std::tr1::unordered_map<Node, CostType, NodeHash> cost_map;
+		typedef flat_hash_map<Node, CostType, NodeHash> cost_map;
 		
-		// Function class to compare nodes by their heuristic values
+		// Function class to compare nodes by their heuristic values, breaking
+		// ties in favor of the larger g
 		struct node_compare : public std::binary_function<Node, Node, bool> {
 			const property_map_open_list<Node, NodeHash, CostType>& ol;
 			node_compare(const property_map_open_list<Node, NodeHash, CostType>& ol) : ol(ol) {}
 			bool operator()(const Node& n1, const Node& n2) {
-				return ol.totalCostEstimate(n1) < ol.totalCostEstimate(n2);
+				CostType f1 = ol.totalCostEstimate(n1);
+				CostType f2 = ol.totalCostEstimate(n2);
+				return f1 < f2 || (f1 == f2 && ol.currentCost(n1) > ol.currentCost(n2));
 			}
 		};
 		
@@ -0,0 +1,94 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#pragma once
+#include "astar.h"
+#include "timer.h"
+#include <algorithm>
+#include <vector>
+
+namespace ac {
+	// Shares a per-frame budget among many resumable searches, such as
+	// astar_search. Pending searches are stepped round robin, at most 'slice'
+	// expansions at a time, and the next frame continues with the search after
+	// the last one that ran. Searches that finish are shrunk to their path and
+	// dropped from the queue; check their status() to find out when they're
+	// done.
+	template <typename Search>
+	class search_scheduler {
+	public:
+		search_scheduler(std::size_t slice = 64) : _slice(std::max<std::size_t>(slice, 1)), _next(0) {
+		}
+
+		// Queues a search. The scheduler doesn't own it, so it has to stay alive
+		// until it finishes or the scheduler is destroyed.
+		void add(Search& s) {
+			_pending.push_back(&s);
+		}
+
+		std::size_t pending() const {
+			return _pending.size();
+		}
+
+		// Runs the pending searches until 'max_expansions' nodes have been
+		// expanded or none is left. Returns the number of expansions used.
+		std::size_t run(std::size_t max_expansions) {
+			return run(max_expansions, 0);
+		}
+
+		// Runs the pending searches until 'seconds' have elapsed or none is left.
+		// The time is checked between slices. Returns the number of expansions
+		// used.
+		std::size_t run_for(double seconds) {
+			return run(std::numeric_limits<std::size_t>::max(), detail::seconds() + seconds);
+		}
+
+	private:
+		std::size_t run(std::size_t max_expansions, double deadline) {
+			if (_pending.empty())
+				return 0;
+
+			// Give every pending search a turn even if the budget is smaller than
+			// a slice per search
+			std::size_t share = std::min(_slice, max_expansions / _pending.size());
+			share = std::max<std::size_t>(share, 1);
+
+			std::size_t used = 0;
+			while (used < max_expansions && !_pending.empty()) {
+				if (deadline != 0 && detail::seconds() >= deadline)
+					break;
+				if (_next >= _pending.size())
+					_next = 0;
+
+				Search& s = *_pending[_next];
+				std::size_t before = s.expansions();
+				search_status status = s.step(std::min(share, max_expansions - used));
+				used += s.expansions() - before;
+
+				if (status == search_in_progress) {
+					_next += 1;
+				} else {
+					s.shrink_to_fit();
+					_pending.erase(_pending.begin() + _next);
+				}
+			}
+			return used;
+		}
+
+	private:
+		std::size_t _slice;
+		std::size_t _next;
+		std::vector<Search*> _pending;
+	};
+}
@@ -0,0 +1,139 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#pragma once
+#include "flat_hash_map.h"
+#include "grid_graph.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace ac {
+	// A set of target nodes on a grid that answers "how far is the closest
+	// target" under the Manhattan distance. It can be passed to
+	// astar::path_to_any as the heuristic for grids with unit costs.
+	//
+	// Targets are sorted into square buckets over their bounding box. A query
+	// scans rings of buckets around the node, closest first, and stops as soon
+	// as the next ring can't hold a closer target. Unless given, the bucket
+	// size is picked so that there is about one target per bucket, otherwise
+	// sparse targets would leave queries scanning rings of empty buckets.
+	class manhattan_target_index {
+	private:
+		typedef flat_hash_set<grid_graph::node, grid_graph::node_hash> target_set;
+
+	public:
+		typedef grid_graph::node node;
+		typedef grid_graph::node_hash node_hash;
+		typedef target_set::const_iterator const_iterator;
+
+	public:
+		// A 'bucket_size' of 0 picks one from the density of the targets
+		manhattan_target_index(const std::vector<node>& targets, int bucket_size = 0) : _bucket_size(bucket_size), _bucket_cols(0), _bucket_rows(0) {
+			if (targets.empty())
+				return;
+
+			node max = _min = targets[0];
+			for (std::size_t i = 0; i < targets.size(); i += 1) {
+				_targets.insert(targets[i]);
+				_min.col = std::min(_min.col, targets[i].col);
+				_min.row = std::min(_min.row, targets[i].row);
+				max.col = std::max(max.col, targets[i].col);
+				max.row = std::max(max.row, targets[i].row);
+			}
+
+			if (_bucket_size <= 0) {
+				double area = double(max.col - _min.col + 1) * (max.row - _min.row + 1);
+				_bucket_size = std::max(1, int(std::sqrt(area / _targets.size()) + 0.5));
+			}
+			_bucket_cols = (max.col - _min.col) / _bucket_size + 1;
+			_bucket_rows = (max.row - _min.row) / _bucket_size + 1;
+			_buckets.resize(std::size_t(_bucket_cols) * _bucket_rows);
+
+			for (target_set::iterator it = _targets.begin(); it != _targets.end(); ++it)
+				_buckets[bucket_index(bucket_col(it->col), bucket_row(it->row))].push_back(*it);
+		}
+
+		bool empty() const { return _targets.empty(); }
+		std::size_t size() const { return _targets.size(); }
+		int bucket_size() const { return _bucket_size; }
+
+		// The targets, each once, in no particular order
+		const_iterator begin() const { return _targets.begin(); }
+		const_iterator end() const { return _targets.end(); }
+
+		bool contains(const node& n) const {
+			return _targets.count(n) != 0;
+		}
+
+		// The Manhattan distance from 'n' to the closest target, or the largest
+		// int if there are no targets
+		int distance(const node& n) const {
+			int best = std::numeric_limits<int>::max();
+			if (empty())
+				return best;
+
+			int center_col = bucket_col(n.col);
+			int center_row = bucket_row(n.row);
+			int max_ring = std::max(std::max(center_col, _bucket_cols - 1 - center_col), std::max(center_row, _bucket_rows - 1 - center_row));
+
+			// Every cell in ring r is at least r - 1 full buckets away from 'n'
+			for (int ring = 0; ring <= max_ring && (ring - 1) * _bucket_size < best; ring += 1) {
+				for (int row = center_row - ring; row <= center_row + ring; row += 1) {
+					if (row < 0 || row >= _bucket_rows)
+						continue;
+					bool edge = row == center_row - ring || row == center_row + ring;
+					int step = edge ? 1 : 2 * ring;
+					for (int col = center_col - ring; col <= center_col + ring; col += step) {
+						if (col >= 0 && col < _bucket_cols)
+							scan(_buckets[bucket_index(col, row)], n, best);
+					}
+				}
+			}
+			return best;
+		}
+
+	private:
+		static void scan(const std::vector<node>& bucket, const node& n, int& best) {
+			for (std::size_t i = 0; i < bucket.size(); i += 1) {
+				int d = std::abs(bucket[i].col - n.col) + std::abs(bucket[i].row - n.row);
+				if (d < best)
+					best = d;
+			}
+		}
+
+		// Nodes outside the bounding box map to the closest bucket
+		int bucket_col(int col) const {
+			return std::max(0, std::min(_bucket_cols - 1, (col - _min.col) / _bucket_size));
+		}
+
+		int bucket_row(int row) const {
+			return std::max(0, std::min(_bucket_rows - 1, (row - _min.row) / _bucket_size));
+		}
+
+		std::size_t bucket_index(int col, int row) const {
+			return std::size_t(row) * _bucket_cols + col;
+		}
+
+	private:
+		int _bucket_size;
+		int _bucket_cols;
+		int _bucket_rows;
+		node _min;
+		std::vector<std::vector<node> > _buckets;
+		target_set _targets;
+	};
+}
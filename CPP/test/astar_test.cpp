@@ -17,6 +17,7 @@
 #include "grid_graph.h"
 #include "manhattan_distance.h"
 #include "property_map_open_list.h"
+#include "target_index.h"
 
 #include <boost/mpl/list.hpp>
 #include <boost/test/unit_test.hpp>
@@ -45,5 +46,156 @@ namespace ac {
 		BOOST_CHECK_EQUAL(path.size(), 9);
 	}
 	
+	BOOST_AUTO_TEST_CASE_TEMPLATE(unreachable, OL, open_list_types) {
+		grid_graph g(5, 5);
+		g.obstacle(node(3,4), true);
+		g.obstacle(node(4,3), true);
+		manhattan_distance h;
+		astar<grid_graph, manhattan_distance, OL> obj(g, h);
+		
+		BOOST_CHECK(obj.path(node(0,0), node(4,4)).empty());
+		BOOST_CHECK_EQUAL(obj.path(node(0,0), node(3,3)).size(), 7);
+	}
+	
+	BOOST_AUTO_TEST_CASE_TEMPLATE(resumable, OL, open_list_types) {
+		grid_graph g(5, 5);
+		astar_search<grid_graph, manhattan_distance, OL> search(g, manhattan_distance(), node(0,0), node(4,4));
+		BOOST_CHECK_EQUAL(search.status(), search_in_progress);
+		
+		BOOST_CHECK_EQUAL(search.step(1), search_in_progress);
+		BOOST_CHECK_EQUAL(search.expansions(), 1);
+		BOOST_CHECK(search.path().empty());
+		
+		while (search.step(2) == search_in_progress)
+			BOOST_CHECK(search.path().empty());
+		BOOST_CHECK_EQUAL(search.status(), search_found);
+		BOOST_CHECK_EQUAL(search.path().size(), 9);
+		
+		search.shrink_to_fit();
+		BOOST_CHECK_EQUAL(search.path().size(), 9);
+		
+		// The same object can run another search
+		g.obstacle(node(0,1), true);
+		g.obstacle(node(1,0), true);
+		search.reset(node(0,0), node(4,4));
+		BOOST_CHECK(search.path().empty());
+		BOOST_CHECK_EQUAL(search.step(100), search_failed);
+	}
+	
+	BOOST_AUTO_TEST_CASE_TEMPLATE(path_buffer, OL, open_list_types) {
+		grid_graph g(5, 5);
+		g.obstacle(node(3,4), true);
+		g.obstacle(node(4,3), true);
+		astar<grid_graph, manhattan_distance, OL> obj(g, manhattan_distance());
+		
+		std::vector<node> path(100, node(9,9));
+		const node* data = &path[0];
+		BOOST_CHECK(obj.path(node(0,0), node(3,3), path));
+		BOOST_CHECK_EQUAL(path.size(), 7);
+		BOOST_CHECK_EQUAL(path.front(), node(0,0));
+		BOOST_CHECK_EQUAL(path.back(), node(3,3));
+		BOOST_CHECK_EQUAL(&path[0], data); // written in place
+		
+		BOOST_CHECK(!obj.path(node(0,0), node(4,4), path));
+		BOOST_CHECK(path.empty());
+		BOOST_CHECK_EQUAL(path.capacity(), 100);
+		
+		BOOST_CHECK(obj.path_to_any(node(0,0), manhattan_target_index(std::vector<node>(1, node(2,2))), path));
+		BOOST_CHECK_EQUAL(path.size(), 5);
+		BOOST_CHECK_EQUAL(&path[0], data);
+	}
+	
+	BOOST_AUTO_TEST_CASE_TEMPLATE(path_to_any, OL, open_list_types) {
+		grid_graph g(10, 10);
+		astar<grid_graph, manhattan_distance, OL> obj(g, manhattan_distance());
+		std::vector<node> targets;
+		targets.push_back(node(9,0));
+		targets.push_back(node(4,4));
+		targets.push_back(node(0,9));
+		manhattan_target_index index(targets, 4);
+		
+		std::vector<node> path = obj.path_to_any(node(0,0), index);
+		BOOST_CHECK_EQUAL(path.size(), 9);
+		BOOST_CHECK_EQUAL(path.back(), node(4,4));
+		
+		// Walling off the closest target sends the search to the next one
+		g.obstacle(node(3,4), true);
+		g.obstacle(node(5,4), true);
+		g.obstacle(node(4,3), true);
+		g.obstacle(node(4,5), true);
+		astar<grid_graph, manhattan_distance, OL> walled(g, manhattan_distance());
+		path = walled.path_to_any(node(0,0), index);
+		BOOST_CHECK_EQUAL(path.size(), 10);
+		BOOST_CHECK(path.back() == node(9,0) || path.back() == node(0,9));
+		
+		BOOST_CHECK(walled.path_to_any(node(0,0), manhattan_target_index(std::vector<node>(1, node(4,4)))).empty());
+		BOOST_CHECK(walled.path_to_any(node(0,0), manhattan_target_index(std::vector<node>())).empty());
+	}
+	
+	BOOST_AUTO_TEST_CASE_TEMPLATE(nearest_sources, OL, open_list_types) {
+		grid_graph g(10, 10);
+		g.obstacle(node(4,0), true);
+		g.obstacle(node(6,0), true);
+		g.obstacle(node(5,1), true);
+		astar<grid_graph, manhattan_distance, OL> obj(g, manhattan_distance());
+		
+		std::vector<node> sources;
+		sources.push_back(node(0,0));
+		sources.push_back(node(9,9));
+		std::vector<node> agents;
+		agents.push_back(node(1,1));
+		agents.push_back(node(8,7));
+		agents.push_back(node(0,0));
+		agents.push_back(node(5,0));
+		agents.push_back(node(1,1));
+		
+		std::vector<int> assignments = obj.nearest_sources(sources, agents);
+		BOOST_REQUIRE_EQUAL(assignments.size(), 5);
+		BOOST_CHECK_EQUAL(assignments[0], 0);
+		BOOST_CHECK_EQUAL(assignments[1], 1);
+		BOOST_CHECK_EQUAL(assignments[2], 0);
+		BOOST_CHECK_EQUAL(assignments[3], -1);
+		BOOST_CHECK_EQUAL(assignments[4], 0);
+		
+		BOOST_CHECK(obj.nearest_sources(std::vector<node>(), agents) == std::vector<int>(5, -1));
+	}
+	
+	BOOST_AUTO_TEST_CASE_TEMPLATE(goal_searches, OL, open_list_types) {
+		// Wall along column 5
+		grid_graph g(10, 10);
+		for (int row = 0; row < 10; row += 1)
+			g.obstacle(node(5,row), true);
+		
+		// No target on the source's side, the search doesn't start
+		manhattan_target_index index(std::vector<node>(1, node(9,9)));
+		typedef nearest_target_goal<grid_graph, manhattan_target_index> target_goal;
+		basic_astar_search<grid_graph, target_goal, OL> to_any(g, target_goal(index, node(0,0)));
+		BOOST_CHECK_EQUAL(to_any.step(1000), search_failed);
+		BOOST_CHECK_EQUAL(to_any.expansions(), 0);
+		
+		// Resumes like a single-target search
+		std::vector<node> targets;
+		targets.push_back(node(9,9));
+		targets.push_back(node(3,3));
+		manhattan_target_index both(targets);
+		to_any.reset(target_goal(both, node(0,0)));
+		BOOST_CHECK_EQUAL(to_any.step(1), search_in_progress);
+		while (to_any.step(1) == search_in_progress) {}
+		BOOST_CHECK_EQUAL(to_any.status(), search_found);
+		BOOST_CHECK_EQUAL(to_any.path().size(), 7);
+		BOOST_CHECK_EQUAL(to_any.goal().target, node(3,3));
+		
+		// The agent behind the wall isn't searched for
+		std::vector<node> agents;
+		agents.push_back(node(9,9));
+		agents.push_back(node(1,0));
+		typedef nearest_source_goal<grid_graph> source_goal;
+		basic_astar_search<grid_graph, source_goal, OL> nearest(g, source_goal(std::vector<node>(1, node(0,0)), agents));
+		BOOST_CHECK_EQUAL(nearest.step(1000), search_found);
+		BOOST_CHECK_EQUAL(nearest.goal().assignments[0], -1);
+		BOOST_CHECK_EQUAL(nearest.goal().assignments[1], 0);
+		BOOST_CHECK(nearest.expansions() < 5);
+	}
+	
 	BOOST_AUTO_TEST_SUITE_END();
 }
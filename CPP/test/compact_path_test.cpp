@@ -0,0 +1,98 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#include "compact_path.h"
+#include "astar.h"
+#include "bimap_open_list.h"
+#include "manhattan_distance.h"
+
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace ac {
+	struct compact_path_test_fixture {
+		typedef grid_graph::node node;
+		typedef bimap_open_list<node, grid_graph::node_hash, grid_graph::cost_type> open_list;
+	};
+	
+	BOOST_FIXTURE_TEST_SUITE(compact_path_test, compact_path_test_fixture);
+	
+	BOOST_AUTO_TEST_CASE(empty) {
+		compact_path p;
+		BOOST_CHECK(p.empty());
+		BOOST_CHECK(p.begin() == p.end());
+		
+		std::vector<node> nodes(1, node(3,4));
+		p.assign(nodes.begin(), nodes.end());
+		BOOST_CHECK_EQUAL(p.size(), 1);
+		BOOST_CHECK(p.runs().empty());
+		BOOST_CHECK_EQUAL(*p.begin(), node(3,4));
+		BOOST_CHECK(++p.begin() == p.end());
+	}
+	
+	BOOST_AUTO_TEST_CASE(runs) {
+		// 100 steps right, 2 up, 1 left: the first run is split at 64
+		std::vector<node> nodes;
+		for (int col = 0; col <= 100; col += 1)
+			nodes.push_back(node(col, 5));
+		nodes.push_back(node(100, 4));
+		nodes.push_back(node(100, 3));
+		nodes.push_back(node(99, 3));
+		
+		compact_path p(nodes.begin(), nodes.end());
+		BOOST_CHECK_EQUAL(p.size(), nodes.size());
+		BOOST_CHECK_EQUAL(p.start(), node(0,5));
+		BOOST_REQUIRE_EQUAL(p.runs().size(), 4);
+		BOOST_CHECK_EQUAL(int(p.runs()[0]), 63 << 2 | 2);
+		BOOST_CHECK_EQUAL(int(p.runs()[1]), 35 << 2 | 2);
+		BOOST_CHECK_EQUAL(int(p.runs()[2]), 1 << 2 | 1);
+		BOOST_CHECK_EQUAL(int(p.runs()[3]), 0 << 2 | 0);
+		BOOST_CHECK(std::equal(nodes.begin(), nodes.end(), p.begin()));
+		
+		// start() and runs() are enough to rebuild it
+		compact_path copy(p.start(), p.runs());
+		BOOST_CHECK_EQUAL(copy.size(), nodes.size());
+		std::vector<node> decoded;
+		copy.decode(decoded);
+		BOOST_CHECK(decoded == nodes);
+	}
+	
+	BOOST_AUTO_TEST_CASE(not_adjacent) {
+		std::vector<node> nodes;
+		nodes.push_back(node(0,0));
+		nodes.push_back(node(1,1));
+		BOOST_CHECK_THROW(compact_path(nodes.begin(), nodes.end()), std::invalid_argument);
+	}
+	
+	BOOST_AUTO_TEST_CASE(astar_path) {
+		std::srand(3);
+		grid_graph g(64, 64);
+		for (int i = 0; i < 600; i += 1)
+			g.obstacle(node(std::rand() % 64, std::rand() % 64), true);
+		g.obstacle(node(0,0), false);
+		g.obstacle(node(63,63), false);
+		astar<grid_graph, manhattan_distance, open_list> obj(g, manhattan_distance());
+		
+		std::vector<node> path;
+		BOOST_REQUIRE(obj.path(node(0,0), node(63,63), path));
+		compact_path p(path.begin(), path.end());
+		BOOST_CHECK_EQUAL(p.size(), path.size());
+		BOOST_CHECK(std::equal(path.begin(), path.end(), p.begin()));
+		BOOST_CHECK_LT(p.runs().size(), path.size());
+	}
+	
+	BOOST_AUTO_TEST_SUITE_END();
+}
@@ -0,0 +1,185 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#include "cooperative_astar.h"
+#include "grid_graph.h"
+#include "manhattan_distance.h"
+
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+
+namespace ac {
+	typedef grid_graph::node node;
+	typedef grid_graph::node_hash node_hash;
+	typedef reservation_table<node, node_hash> table;
+	typedef cooperative_astar<grid_graph, manhattan_distance> whca;
+
+	struct cooperative_astar_test_fixture {
+		// Checks that no two agents occupy the same node at the same time or
+		// swap places between two consecutive times. An agent whose path ends
+		// early stays at its last node.
+		static void check_no_conflicts(const whca& obj) {
+			for (std::size_t a = 0; a < obj.agent_count(); a += 1) {
+				for (std::size_t b = a + 1; b < obj.agent_count(); b += 1) {
+					for (int t = 0; t <= obj.window(); t += 1) {
+						BOOST_CHECK(!(at(obj, a, t) == at(obj, b, t)));
+						if (t > 0)
+							BOOST_CHECK(!(at(obj, a, t) == at(obj, b, t - 1) && at(obj, a, t - 1) == at(obj, b, t)));
+					}
+				}
+			}
+		}
+
+		static node at(const whca& obj, int agent, int t) {
+			const std::vector<node>& path = obj.path(agent);
+			return path[std::min<std::size_t>(t, path.size() - 1)];
+		}
+	};
+
+	BOOST_FIXTURE_TEST_SUITE(cooperative_astar_test, cooperative_astar_test_fixture);
+
+	BOOST_AUTO_TEST_CASE(reservations) {
+		table r;
+		r.reserve(node(1, 0), 0, 0);
+		r.reserve(node(2, 0), 1, 0);
+
+		BOOST_CHECK_EQUAL(r.owner(node(1, 0), 0), 0);
+		BOOST_CHECK_EQUAL(r.owner(node(1, 0), 1), table::none);
+		BOOST_CHECK(r.reserved(node(2, 0), 1, 1));
+		BOOST_CHECK(!r.reserved(node(2, 0), 1, 0));
+
+		// Agent 1 can't enter a reserved node
+		BOOST_CHECK(!r.can_move(1, node(3, 0), node(2, 0), 0));
+
+		// Agent 1 can't swap places with agent 0
+		BOOST_CHECK(!r.can_move(1, node(2, 0), node(1, 0), 0));
+		BOOST_CHECK(r.can_move(1, node(2, 1), node(1, 0), 1));
+	}
+
+	BOOST_AUTO_TEST_CASE(true_distance_around_wall) {
+		grid_graph g(5, 5);
+		g.obstacle(node(2, 0), true);
+		g.obstacle(node(2, 1), true);
+		g.obstacle(node(2, 2), true);
+		g.obstacle(node(2, 3), true);
+
+		true_distance<grid_graph, manhattan_distance> d(g, manhattan_distance(), node(4, 0), node(0, 0));
+		BOOST_CHECK_EQUAL(d(node(0, 0)), 12);
+		BOOST_CHECK_EQUAL(d(node(4, 0)), 0);
+		BOOST_CHECK_EQUAL(d(node(1, 0)), 11);
+		BOOST_CHECK_EQUAL(d(node(2, 0)), std::numeric_limits<int>::max());
+	}
+
+	BOOST_AUTO_TEST_CASE(true_distance_budget) {
+		grid_graph g(5, 5);
+		g.obstacle(node(2, 0), true);
+		g.obstacle(node(2, 1), true);
+		g.obstacle(node(2, 2), true);
+		g.obstacle(node(2, 3), true);
+
+		// Out of budget the result is a lower bound that tightens as the
+		// search goes on
+		true_distance<grid_graph, manhattan_distance> d(g, manhattan_distance(), node(4, 0), node(0, 0));
+		std::size_t budget = 0;
+		BOOST_CHECK_EQUAL(d(node(0, 0), budget), 4);
+		budget = 5;
+		int bound = d(node(0, 0), budget);
+		BOOST_CHECK_EQUAL(budget, 0);
+		BOOST_CHECK_GT(bound, 4);
+		BOOST_CHECK_LE(bound, 12);
+
+		budget = 100;
+		BOOST_CHECK_EQUAL(d(node(0, 0), budget), 12);
+		BOOST_CHECK_GT(budget, 0);
+		BOOST_CHECK_EQUAL(d.estimate(node(0, 0)), 12);
+	}
+
+	BOOST_AUTO_TEST_CASE(single_agent) {
+		grid_graph g(5, 5);
+		whca obj(g, manhattan_distance(), 8);
+		int a = obj.add_agent(node(0, 0), node(3, 0));
+		obj.plan();
+
+		const std::vector<node>& path = obj.path(a);
+		BOOST_CHECK_EQUAL(path.size(), 9);
+		BOOST_CHECK_EQUAL(path[0], node(0, 0));
+		BOOST_CHECK_EQUAL(path[3], node(3, 0));
+		BOOST_CHECK_EQUAL(path[8], node(3, 0));
+	}
+
+	BOOST_AUTO_TEST_CASE(corridor_swap) {
+		// A corridor along row 0 with a single pocket at (3, 1)
+		grid_graph g(5, 2);
+		g.obstacle(node(0, 1), true);
+		g.obstacle(node(1, 1), true);
+		g.obstacle(node(2, 1), true);
+		g.obstacle(node(4, 1), true);
+
+		whca obj(g, manhattan_distance(), 8);
+		int a = obj.add_agent(node(0, 0), node(4, 0));
+		int b = obj.add_agent(node(4, 0), node(0, 0));
+		for (int i = 0; i < 4; i += 1) {
+			obj.plan();
+			check_no_conflicts(obj);
+			obj.advance(4);
+		}
+
+		BOOST_CHECK_EQUAL(obj.position(a), node(4, 0));
+		BOOST_CHECK_EQUAL(obj.position(b), node(0, 0));
+	}
+
+	BOOST_AUTO_TEST_CASE(boxed_in) {
+		// Agent 0 goes through the cell where agent 1 is parked. Agent 1 has no
+		// way out of the corridor, so it has to plan first.
+		grid_graph g(5, 1);
+		whca obj(g, manhattan_distance(), 8);
+		int a = obj.add_agent(node(0, 0), node(4, 0));
+		int b = obj.add_agent(node(2, 0), node(2, 0));
+		obj.plan();
+		check_no_conflicts(obj);
+
+		BOOST_CHECK(obj.planned(a));
+		BOOST_CHECK(obj.planned(b));
+		BOOST_CHECK_EQUAL(obj.path(a).size(), 9);
+		BOOST_CHECK_EQUAL(obj.path(b).size(), 9);
+		BOOST_CHECK_EQUAL(obj.path(b)[8], node(2, 0));
+	}
+
+	BOOST_AUTO_TEST_CASE(plan_for) {
+		grid_graph g(10, 10);
+		whca obj(g, manhattan_distance(), 10);
+		for (int i = 0; i < 10; i += 1)
+			obj.add_agent(node(0, i), node(9, 9 - i));
+
+		// Without time each call still plans one agent
+		int calls = 1;
+		while (!obj.plan_for(0))
+			calls += 1;
+		BOOST_CHECK_GE(calls, 2);
+		check_no_conflicts(obj);
+		for (int i = 0; i < 10; i += 1)
+			BOOST_CHECK(obj.planned(i));
+	}
+
+	BOOST_AUTO_TEST_CASE(crowd) {
+		grid_graph g(10, 10);
+		whca obj(g, manhattan_distance(), 10);
+		for (int i = 0; i < 10; i += 1)
+			obj.add_agent(node(0, i), node(9, 9 - i));
+		obj.plan();
+		check_no_conflicts(obj);
+	}
+
+	BOOST_AUTO_TEST_SUITE_END();
+}
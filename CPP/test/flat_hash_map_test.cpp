@@ -0,0 +1,120 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#include "flat_hash_map.h"
+#include "grid_graph.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace ac {
+	typedef grid_graph::node node;
+	typedef grid_graph::node_hash node_hash;
+
+	// Maps every key to the same slot, to exercise long probe runs
+	struct constant_hash : public std::unary_function<int, std::size_t> {
+		std::size_t operator()(int) const { return 7; }
+	};
+
+	struct flat_hash_map_test_fixture {
+	};
+
+	BOOST_FIXTURE_TEST_SUITE(flat_hash_map_test, flat_hash_map_test_fixture);
+
+	BOOST_AUTO_TEST_CASE(insert_find) {
+		flat_hash_map<node, int, node_hash> map;
+		BOOST_CHECK(map.empty());
+		BOOST_CHECK(map.find(node(0, 0)) == map.end());
+
+		BOOST_CHECK(map.insert(std::make_pair(node(1, 2), 3)).second);
+		BOOST_CHECK(!map.insert(std::make_pair(node(1, 2), 4)).second);
+		map[node(2, 1)] = 5;
+
+		BOOST_CHECK_EQUAL(map.size(), 2);
+		BOOST_CHECK_EQUAL(map.find(node(1, 2))->second, 3);
+		BOOST_CHECK_EQUAL(map[node(2, 1)], 5);
+		BOOST_CHECK_EQUAL(map.count(node(3, 3)), 0);
+	}
+
+	BOOST_AUTO_TEST_CASE(erase) {
+		flat_hash_map<int, int, constant_hash> map;
+		for (int i = 0; i < 100; i += 1)
+			map[i] = i * 2;
+
+		for (int i = 0; i < 100; i += 3)
+			BOOST_CHECK_EQUAL(map.erase(i), 1);
+		BOOST_CHECK_EQUAL(map.erase(0), 0);
+
+		for (int i = 0; i < 100; i += 1) {
+			if (i % 3 == 0)
+				BOOST_CHECK(map.find(i) == map.end());
+			else
+				BOOST_CHECK_EQUAL(map.find(i)->second, i * 2);
+		}
+		BOOST_CHECK_EQUAL(map.size(), 66);
+	}
+
+	BOOST_AUTO_TEST_CASE(iterate) {
+		flat_hash_set<node, node_hash> set;
+		for (int col = 0; col < 50; col += 1) {
+			for (int row = 0; row < 50; row += 1)
+				set.insert(node(col, row));
+		}
+
+		std::size_t count = 0;
+		for (flat_hash_set<node, node_hash>::const_iterator it = set.begin(); it != set.end(); ++it) {
+			BOOST_CHECK(it->col >= 0 && it->col < 50);
+			count += 1;
+		}
+		BOOST_CHECK_EQUAL(count, 2500);
+
+		set.clear();
+		BOOST_CHECK(set.empty());
+		BOOST_CHECK(set.begin() == set.end());
+		BOOST_CHECK(set.bucket_count() > 0);
+	}
+
+	BOOST_AUTO_TEST_CASE(probe_lengths) {
+		flat_hash_set<int, constant_hash> set;
+		for (int i = 0; i < 300; i += 1)
+			set.insert(i);
+
+		// All elements share a home slot so they occupy one probe distance each,
+		// including the ones past the saturated control byte
+		std::vector<std::size_t> histogram = set.probe_lengths();
+		BOOST_CHECK_EQUAL(histogram.size(), 300);
+		for (std::size_t i = 0; i < histogram.size(); i += 1)
+			BOOST_CHECK_EQUAL(histogram[i], 1);
+		for (int i = 0; i < 300; i += 1)
+			BOOST_CHECK_EQUAL(set.count(i), 1);
+	}
+
+	BOOST_AUTO_TEST_CASE(node_hash_mixing) {
+		node_hash h;
+		BOOST_CHECK(h(node(1, 1)) != h(node(2, 2)));
+		BOOST_CHECK(h(node(1, 2)) != h(node(2, 1)));
+		BOOST_CHECK(h(node(0, 0)) != h(node(3, 3)));
+	}
+
+	BOOST_AUTO_TEST_CASE(identity_hash) {
+		// tr1::hash<long> is the identity and these keys share their low 16 bits
+		flat_hash_set<long> set;
+		for (long i = 0; i < 4096; i += 1)
+			set.insert(i << 16);
+		BOOST_CHECK_EQUAL(set.size(), 4096);
+		BOOST_CHECK_LT(set.probe_lengths().size(), 32);
+		BOOST_CHECK_EQUAL(set.count(4095L << 16), 1);
+	}
+
+	BOOST_AUTO_TEST_SUITE_END();
+}
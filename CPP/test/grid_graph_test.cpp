@@ -19,6 +19,12 @@
 namespace ac {
 	struct grid_graph_test_fixture {
 		typedef grid_graph::node node;
+		
+		struct components_obstacle {
+			const grid_graph& g;
+			components_obstacle(const grid_graph& g) : g(g) {}
+			bool operator()(int col, int row) const { return g.obstacle(node(col, row)); }
+		};
 	};
 	
 	BOOST_FIXTURE_TEST_SUITE(grid_graph_test, grid_graph_test_fixture);
@@ -96,5 +102,147 @@ namespace ac {
 		BOOST_CHECK_EQUAL(nodes.size(), 0);
 	}
 	
+	BOOST_AUTO_TEST_CASE(reset_obstacle) {
+		grid_graph g(5, 5);
+		g.obstacle(node(1,1), true);
+		g.obstacle(node(1,1), false);
+		BOOST_CHECK(!g.obstacle(node(1,1)));
+	}
+	
+	BOOST_AUTO_TEST_CASE(connected) {
+		grid_graph g(5, 5);
+		BOOST_CHECK(g.connected(node(0,0), node(4,4)));
+		
+		// Wall along column 2
+		for (int row = 0; row < 5; row += 1)
+			g.obstacle(node(2,row), true);
+		BOOST_CHECK(!g.connected(node(0,0), node(4,4)));
+		BOOST_CHECK(g.connected(node(0,0), node(1,4)));
+		BOOST_CHECK(g.connected(node(3,0), node(4,4)));
+		
+		// Searches can start inside an obstacle but never end in one
+		BOOST_CHECK(g.connected(node(2,2), node(4,4)));
+		BOOST_CHECK(!g.connected(node(4,4), node(2,2)));
+		BOOST_CHECK(g.connected(node(2,2), node(2,2)));
+		
+		// Opening a gap merges both sides
+		g.obstacle(node(2,3), false);
+		BOOST_CHECK(g.connected(node(0,0), node(4,4)));
+		BOOST_CHECK(g.connected(node(2,3), node(4,4)));
+		
+		// Closing it again splits them
+		g.obstacle(node(2,3), true);
+		BOOST_CHECK(!g.connected(node(0,0), node(4,4)));
+	}
+	
+	BOOST_AUTO_TEST_CASE(components_in_place) {
+		// Rows 0 and 2 only connect through (4,1), (0,0) is a dead end
+		grid_graph g(5, 3);
+		for (int col = 0; col < 4; col += 1)
+			g.obstacle(node(col,1), true);
+		grid_components components;
+		components.build(g.col_count(), g.row_count(), components_obstacle(g));
+		BOOST_CHECK(components.connected(0, 0, 0, 2));
+		
+		// (0,0) is the root of its tree, blocking it leaves it in the forest
+		components.blocked(0, 0);
+		BOOST_CHECK(!components.stale());
+		BOOST_CHECK(!components.connected(0, 0, 0, 2));
+		BOOST_CHECK(components.connected(1, 0, 0, 2));
+		components.freed(0, 0);
+		BOOST_CHECK(!components.stale());
+		BOOST_CHECK(components.connected(0, 0, 0, 2));
+		
+		// Blocking (4,1) splits both rows apart
+		components.blocked(4, 1);
+		BOOST_CHECK(!components.stale());
+		BOOST_CHECK(!components.connected(0, 0, 0, 2));
+		BOOST_CHECK(components.connected(0, 0, 4, 0));
+		BOOST_CHECK(components.connected(0, 2, 4, 2));
+		components.freed(4, 1);
+		BOOST_CHECK(!components.stale());
+		BOOST_CHECK(components.connected(0, 0, 0, 2));
+		
+		// Blocking (2,2) splits the bottom row, blocking (1,0) cuts off (0,0)
+		components.blocked(2, 2);
+		components.blocked(1, 0);
+		BOOST_CHECK(!components.stale());
+		BOOST_CHECK(!components.connected(0, 2, 3, 2));
+		BOOST_CHECK(components.connected(2, 0, 3, 2));
+		BOOST_CHECK(!components.connected(0, 0, 2, 0));
+	}
+	
+	BOOST_AUTO_TEST_CASE(components_node_limit) {
+		// Freeing a blocked dead end adds a node, three times fill the forest of
+		// a 3x1 corridor
+		grid_graph g(3, 1);
+		grid_components components;
+		components.build(g.col_count(), g.row_count(), components_obstacle(g));
+		for (int i = 0; i < 3; i += 1) {
+			components.blocked(0, 0);
+			components.freed(0, 0);
+		}
+		BOOST_CHECK(!components.stale());
+		BOOST_CHECK(components.connected(0, 0, 2, 0));
+		
+		// A split that can't relabel gives up and leaves the forest stale
+		components.blocked(1, 0);
+		BOOST_CHECK(components.stale());
+		
+		// Same through the graph, which rebuilds
+		for (int i = 0; i < 3; i += 1) {
+			g.obstacle(node(0,0), true);
+			g.obstacle(node(0,0), false);
+		}
+		BOOST_CHECK(g.connected(node(0,0), node(2,0)));
+		g.obstacle(node(1,0), true);
+		BOOST_CHECK(!g.connected(node(0,0), node(2,0)));
+	}
+	
+	BOOST_AUTO_TEST_CASE(components_large_split) {
+		// Two large halves joined by a gap at (100,0)
+		grid_graph g(201, 200);
+		for (int row = 1; row < 200; row += 1)
+			g.obstacle(node(100,row), true);
+		grid_components components;
+		components.build(g.col_count(), g.row_count(), components_obstacle(g));
+		
+		components.blocked(100, 0);
+		BOOST_CHECK(components.stale());
+		
+		g.obstacle(node(100,0), true);
+		components.build(g.col_count(), g.row_count(), components_obstacle(g));
+		BOOST_CHECK(!components.connected(0, 0, 200, 0));
+		BOOST_CHECK(components.connected(0, 0, 99, 199));
+		
+		// A cell with four free neighbors in the same half
+		components.blocked(50, 50);
+		BOOST_CHECK(!components.stale());
+		BOOST_CHECK(components.connected(50, 49, 50, 51));
+		BOOST_CHECK(components.connected(49, 50, 51, 50));
+	}
+	
+	BOOST_AUTO_TEST_CASE(connected_bands) {
+		// Tall enough to be split into bands, with a maze-like pattern of
+		// walls that only connect through the last column
+		grid_graph g(8, 300);
+		for (int row = 1; row < 300; row += 2) {
+			for (int col = 0; col < 7; col += 1)
+				g.obstacle(node(row % 4 == 1 ? col : col + 1, row), true);
+		}
+		
+		grid_components components;
+		for (unsigned threads = 1; threads <= 4; threads += 1) {
+			components.build(g.col_count(), g.row_count(), components_obstacle(g), threads);
+			BOOST_CHECK(components.connected(0, 0, 0, 298));
+			BOOST_CHECK(components.connected(7, 1, 0, 298));
+			BOOST_CHECK(!components.connected(0, 1, 0, 0));
+		}
+		
+		g.obstacle(node(7,1), true);
+		BOOST_CHECK(!g.connected(node(0,0), node(0,298)));
+		BOOST_CHECK(g.connected(node(0,2), node(0,298)));
+	}
+	
 	BOOST_AUTO_TEST_SUITE_END();
 }
@@ -14,6 +14,7 @@
 
 #include "grid_graph.h"
 #include "bimap_open_list.h"
+#include "heap_open_list.h"
 #include "property_map_open_list.h"
 
 #include <boost/test/unit_test.hpp>
@@ -25,7 +26,8 @@ namespace ac {
 	typedef grid_graph::cost_type cost;
 	typedef bimap_open_list<node, node_hash, cost> bimap;
 	typedef property_map_open_list<node, node_hash, cost> property;
-	typedef boost::mpl::list<bimap, property> open_list_types;
+	typedef heap_open_list<node, node_hash, cost> heap;
+	typedef boost::mpl::list<bimap, property, heap> open_list_types;
 	
 	struct open_list_test_fixture {
 	};
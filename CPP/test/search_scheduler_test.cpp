@@ -0,0 +1,83 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#include "bimap_open_list.h"
+#include "grid_graph.h"
+#include "manhattan_distance.h"
+#include "search_scheduler.h"
+
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace ac {
+	struct search_scheduler_test_fixture {
+		typedef grid_graph::node node;
+		typedef bimap_open_list<node, grid_graph::node_hash, grid_graph::cost_type> open_list;
+		typedef astar_search<grid_graph, manhattan_distance, open_list> search;
+	};
+
+	BOOST_FIXTURE_TEST_SUITE(search_scheduler_test, search_scheduler_test_fixture);
+
+	BOOST_AUTO_TEST_CASE(round_robin) {
+		grid_graph g(20, 20);
+		boost::ptr_vector<search> searches;
+		search_scheduler<search> scheduler(4);
+		for (int i = 0; i < 10; i += 1) {
+			searches.push_back(new search(g, manhattan_distance(), node(0, i), node(19, 19 - i)));
+			scheduler.add(searches.back());
+		}
+
+		// A budget smaller than one slice per search is spread one expansion each
+		BOOST_CHECK_EQUAL(scheduler.run(5), 5);
+		for (int i = 0; i < 10; i += 1)
+			BOOST_CHECK_EQUAL(searches[i].expansions(), i < 5 ? 1 : 0);
+
+		// The next frame picks up where the last one stopped
+		BOOST_CHECK_EQUAL(scheduler.run(5), 5);
+		for (int i = 0; i < 10; i += 1)
+			BOOST_CHECK_EQUAL(searches[i].expansions(), 1);
+
+		// Then every search gets a full slice
+		BOOST_CHECK_EQUAL(scheduler.run(40), 40);
+		for (int i = 0; i < 10; i += 1)
+			BOOST_CHECK_EQUAL(searches[i].expansions(), 5);
+
+		while (scheduler.pending() > 0)
+			scheduler.run(50);
+		for (int i = 0; i < 10; i += 1) {
+			BOOST_CHECK_EQUAL(searches[i].status(), search_found);
+			BOOST_CHECK_EQUAL(searches[i].path().size(), 20 + std::abs(19 - 2 * i));
+		}
+	}
+
+	BOOST_AUTO_TEST_CASE(failures) {
+		grid_graph g(5, 5);
+		g.obstacle(node(3, 4), true);
+		g.obstacle(node(4, 3), true);
+
+		search unreachable(g, manhattan_distance(), node(0, 0), node(4, 4));
+		search reachable(g, manhattan_distance(), node(0, 0), node(3, 3));
+		search_scheduler<search> scheduler;
+		scheduler.add(unreachable);
+		scheduler.add(reachable);
+		scheduler.run_for(1);
+
+		BOOST_CHECK_EQUAL(scheduler.pending(), 0);
+		BOOST_CHECK_EQUAL(unreachable.status(), search_failed);
+		BOOST_CHECK_EQUAL(reachable.status(), search_found);
+		BOOST_CHECK_EQUAL(reachable.path().size(), 7);
+	}
+
+	BOOST_AUTO_TEST_SUITE_END();
+}
@@ -0,0 +1,95 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#include "target_index.h"
+#include "manhattan_distance.h"
+
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <limits>
+
+namespace ac {
+	struct target_index_test_fixture {
+		typedef grid_graph::node node;
+		
+		static int closest(const std::vector<node>& targets, const node& n) {
+			int best = std::numeric_limits<int>::max();
+			for (std::size_t i = 0; i < targets.size(); i += 1)
+				best = std::min(best, manhattan_distance()(targets[i], n));
+			return best;
+		}
+	};
+	
+	BOOST_FIXTURE_TEST_SUITE(target_index_test, target_index_test_fixture);
+	
+	BOOST_AUTO_TEST_CASE(empty) {
+		manhattan_target_index index((std::vector<node>()));
+		BOOST_CHECK(index.empty());
+		BOOST_CHECK(!index.contains(node(0,0)));
+		BOOST_CHECK_EQUAL(index.distance(node(0,0)), std::numeric_limits<int>::max());
+	}
+	
+	BOOST_AUTO_TEST_CASE(contains) {
+		std::vector<node> targets;
+		targets.push_back(node(3,7));
+		targets.push_back(node(40,2));
+		targets.push_back(node(3,7));
+		manhattan_target_index index(targets);
+		BOOST_CHECK_EQUAL(index.size(), 2);
+		BOOST_CHECK(index.contains(node(3,7)));
+		BOOST_CHECK(index.contains(node(40,2)));
+		BOOST_CHECK(!index.contains(node(7,3)));
+		BOOST_CHECK_EQUAL(index.distance(node(3,7)), 0);
+	}
+	
+	BOOST_AUTO_TEST_CASE(matches_brute_force) {
+		std::srand(7);
+		int bucket_sizes[] = {1, 4, 16, 64};
+		for (int b = 0; b < 4; b += 1) {
+			std::vector<node> targets;
+			for (int i = 0; i < 50; i += 1)
+				targets.push_back(node(std::rand() % 200, std::rand() % 100));
+			manhattan_target_index index(targets, bucket_sizes[b]);
+			
+			// Queries include nodes outside the targets' bounding box
+			for (int i = 0; i < 500; i += 1) {
+				node n(std::rand() % 300 - 50, std::rand() % 200 - 50);
+				BOOST_REQUIRE_EQUAL(index.distance(n), closest(targets, n));
+			}
+		}
+	}
+	
+	BOOST_AUTO_TEST_CASE(sparse) {
+		// Two targets far apart get a few large buckets, not rings of empty ones
+		std::vector<node> targets;
+		targets.push_back(node(0,0));
+		targets.push_back(node(4095,4095));
+		manhattan_target_index index(targets);
+		BOOST_CHECK(index.bucket_size() > 1024);
+		BOOST_CHECK_EQUAL(index.distance(node(2000,2000)), 4000);
+		BOOST_CHECK_EQUAL(index.distance(node(4000,2500)), 1690);
+		
+		std::srand(11);
+		targets.clear();
+		for (int i = 0; i < 20; i += 1)
+			targets.push_back(node(std::rand() % 4096, std::rand() % 4096));
+		manhattan_target_index random(targets);
+		for (int i = 0; i < 500; i += 1) {
+			node n(std::rand() % 4096, std::rand() % 4096);
+			BOOST_REQUIRE_EQUAL(random.distance(n), closest(targets, n));
+		}
+	}
+	
+	BOOST_AUTO_TEST_SUITE_END();
+}
@@ -0,0 +1,130 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#include "astar.h"
+#include "bimap_open_list.h"
+#include "manhattan_distance.h"
+#include "tiled_grid_graph.h"
+
+#include <boost/test/unit_test.hpp>
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace ac {
+	struct tiled_grid_graph_test_fixture {
+		typedef grid_graph::node node;
+		std::string directory;
+
+		tiled_grid_graph_test_fixture() {
+			char name[] = "/tmp/tiled_grid_graph_test.XXXXXX";
+			directory = mkdtemp(name);
+		}
+
+		~tiled_grid_graph_test_fixture() {
+			DIR* dir = opendir(directory.c_str());
+			while (dirent* entry = readdir(dir)) {
+				std::string name = entry->d_name;
+				if (name != "." && name != "..")
+					unlink((directory + "/" + name).c_str());
+			}
+			closedir(dir);
+			rmdir(directory.c_str());
+		}
+
+		// Builds a wall along column 10 with a single gap at row 19
+		void build_wall(tiled_grid_graph& g) {
+			for (int row = 0; row < 19; row += 1)
+				g.obstacle(node(10, row), true);
+		}
+	};
+
+	BOOST_FIXTURE_TEST_SUITE(tiled_grid_graph_test, tiled_grid_graph_test_fixture);
+
+	BOOST_AUTO_TEST_CASE(run_length_encoding) {
+		std::vector<bool> cells(300, false);
+		cells[0] = true;
+		std::fill(cells.begin() + 100, cells.begin() + 299, true);
+
+		std::string data;
+		detail::encode_runs(cells, data);
+		BOOST_CHECK_EQUAL(data.size(), 6);
+
+		std::vector<bool> decoded(300, false);
+		BOOST_CHECK(detail::decode_runs(data, decoded));
+		BOOST_CHECK(decoded == cells);
+
+		std::vector<bool> too_small(200, false);
+		BOOST_CHECK(!detail::decode_runs(data, too_small));
+	}
+
+	BOOST_AUTO_TEST_CASE(persist) {
+		tiled_grid_graph::create(directory, 20, 20, 8);
+		{
+			tiled_grid_graph g(directory, 2, 0);
+			BOOST_CHECK_EQUAL(g.col_count(), 20);
+			BOOST_CHECK_EQUAL(g.row_count(), 20);
+			build_wall(g);
+			g.obstacle(node(10, 0), false);
+			BOOST_CHECK(g.stats().evictions > 0);
+		}
+
+		tiled_grid_graph g(directory, 1, 0);
+		BOOST_CHECK(!g.obstacle(node(10, 0)));
+		BOOST_CHECK(g.obstacle(node(10, 1)));
+		BOOST_CHECK(g.obstacle(node(10, 18)));
+		BOOST_CHECK(!g.obstacle(node(10, 19)));
+		BOOST_CHECK(!g.obstacle(node(9, 18)));
+		BOOST_CHECK(g.obstacle(node(20, 0)));
+	}
+
+	BOOST_AUTO_TEST_CASE(search) {
+		tiled_grid_graph::create(directory, 20, 20, 8);
+		{
+			tiled_grid_graph g(directory, 9, 0);
+			build_wall(g);
+		}
+
+		tiled_grid_graph g(directory, 3, 2);
+		typedef bimap_open_list<node, grid_graph::node_hash, grid_graph::cost_type> open_list;
+		astar<tiled_grid_graph, manhattan_distance, open_list> obj(g, manhattan_distance());
+		std::vector<node> path = obj.path(node(0, 0), node(19, 0));
+		BOOST_CHECK_EQUAL(path.size(), 58);
+
+		tile_cache_stats stats = g.stats();
+		BOOST_CHECK(stats.misses + stats.prefetch_hits >= 6);
+		BOOST_CHECK(stats.hits > 0);
+		BOOST_CHECK(stats.hit_rate() > 0.9);
+	}
+
+	BOOST_AUTO_TEST_CASE(unused_prefetches_age_out) {
+		tiled_grid_graph::create(directory, 24, 64, 8);
+		tiled_grid_graph g(directory, 2, 2);
+
+		// Two prefetches of tiles in the third column that are never used
+		g.adjacent_nodes(node(14, 4));
+		g.adjacent_nodes(node(14, 12));
+		g.wait_for_prefetches();
+
+		g.reset_stats();
+		for (int row = 0; row < 64; row += 1)
+			g.adjacent_nodes(node(0, row));
+
+		tile_cache_stats stats = g.stats();
+		BOOST_CHECK_EQUAL(stats.prefetch_hits, 7);
+		BOOST_CHECK_EQUAL(stats.misses, 1);
+	}
+
+	BOOST_AUTO_TEST_SUITE_END();
+}
@@ -0,0 +1,114 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#include "astar.h"
+#include "bimap_open_list.h"
+#include "manhattan_distance.h"
+#include "versioned_grid_graph.h"
+
+#include <boost/atomic.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace ac {
+	struct versioned_grid_graph_test_fixture {
+		typedef versioned_grid_graph::node node;
+		typedef versioned_grid_graph::snapshot snapshot;
+		typedef bimap_open_list<node, grid_graph::node_hash, grid_graph::cost_type> open_list;
+
+		// Searches snapshots across a column that's being blocked and
+		// unblocked, and checks every path against its own snapshot
+		static void search(const versioned_grid_graph& g, boost::atomic<bool>& done, boost::atomic<int>& errors) {
+			while (!done.load()) {
+				snapshot s = g.read();
+				astar<snapshot, manhattan_distance, open_list> obj(s, manhattan_distance());
+				std::vector<node> path = obj.path(node(0, 0), node(15, 15));
+				for (std::size_t i = 0; i < path.size(); i += 1) {
+					if (s.obstacle(path[i]))
+						errors.fetch_add(1);
+				}
+			}
+		}
+	};
+
+	BOOST_FIXTURE_TEST_SUITE(versioned_grid_graph_test, versioned_grid_graph_test_fixture);
+
+	BOOST_AUTO_TEST_CASE(isolation) {
+		versioned_grid_graph g(10, 10, 4);
+		snapshot before = g.read();
+		g.obstacle(node(1, 1), true);
+		snapshot after = g.read();
+
+		BOOST_CHECK(!before.obstacle(node(1, 1)));
+		BOOST_CHECK(after.obstacle(node(1, 1)));
+		BOOST_CHECK(after.obstacle(node(10, 0)));
+		BOOST_CHECK_EQUAL(before.version_number(), 0);
+		BOOST_CHECK_EQUAL(after.version_number(), 1);
+
+		std::vector<node> nodes = after.adjacent_nodes(node(1, 0));
+		BOOST_CHECK_EQUAL(nodes.size(), 2);
+		BOOST_CHECK_EQUAL(nodes[0], node(0, 0));
+		BOOST_CHECK_EQUAL(nodes[1], node(2, 0));
+
+		g.obstacle(node(1, 1), false);
+		BOOST_CHECK(after.obstacle(node(1, 1)));
+		BOOST_CHECK(!g.read().obstacle(node(1, 1)));
+	}
+
+	BOOST_AUTO_TEST_CASE(reclamation) {
+		versioned_grid_graph g(10, 10, 4);
+		{
+			snapshot s = g.read();
+			g.obstacle(node(1, 1), true);
+			g.obstacle(node(2, 2), true);
+			BOOST_CHECK_EQUAL(g.retired_count(), 2);
+
+			snapshot copy = s;
+			BOOST_CHECK(!copy.obstacle(node(2, 2)));
+		}
+
+		g.obstacle(node(3, 3), true);
+		BOOST_CHECK_EQUAL(g.retired_count(), 0);
+	}
+
+	BOOST_AUTO_TEST_CASE(reader_limit) {
+		versioned_grid_graph g(10, 10, 4, 2);
+		snapshot s1 = g.read();
+		snapshot s2 = g.read();
+		BOOST_CHECK_THROW(g.read(), std::runtime_error);
+	}
+
+	BOOST_AUTO_TEST_CASE(concurrent_search) {
+		versioned_grid_graph g(16, 16, 4);
+		boost::atomic<bool> done(false);
+		boost::atomic<int> errors(0);
+
+		boost::thread_group readers;
+		for (int i = 0; i < 4; i += 1)
+			readers.create_thread(boost::bind(&search, boost::cref(g), boost::ref(done), boost::ref(errors)));
+
+		std::vector<node> column;
+		for (int row = 0; row < 15; row += 1)
+			column.push_back(node(8, row));
+		for (int i = 0; i < 200; i += 1)
+			g.obstacles(column, i % 2 == 0);
+
+		done.store(true);
+		readers.join_all();
+		BOOST_CHECK_EQUAL(errors.load(), 0);
+	}
+
+	BOOST_AUTO_TEST_SUITE_END();
+}
@@ -0,0 +1,512 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#pragma once
+#include "flat_hash_map.h"
+#include "grid_graph.h"
+#include "timer.h"
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ac {
+	// Tile cache counters of a tiled_grid_graph
+	struct tile_cache_stats {
+		std::size_t hits;          // tile accesses served from memory
+		std::size_t misses;        // tiles read from disk on demand
+		std::size_t prefetch_hits; // tiles that had already been read by the prefetcher
+		std::size_t evictions;
+		double io_seconds;          // time spent reading tiles or waiting for the prefetcher
+		double prefetch_io_seconds; // time the prefetcher spent reading tiles in the background
+
+		tile_cache_stats() : hits(), misses(), prefetch_hits(), evictions(), io_seconds(), prefetch_io_seconds() {}
+
+		double hit_rate() const {
+			std::size_t total = hits + misses + prefetch_hits;
+			return total == 0 ? 0 : double(hits + prefetch_hits) / total;
+		}
+	};
+
+	namespace detail {
+		// Encodes cells as alternating runs of free and blocked cells, starting
+		// with a (possibly empty) run of free cells. Each run length is stored as
+		// a little-endian base-128 varint.
+		inline void encode_runs(const std::vector<bool>& cells, std::string& out) {
+			out.clear();
+			bool value = false;
+			std::size_t i = 0;
+			while (i < cells.size()) {
+				std::size_t run = 0;
+				while (i < cells.size() && cells[i] == value) {
+					run += 1;
+					i += 1;
+				}
+				while (run >= 0x80) {
+					out.push_back(static_cast<char>((run & 0x7f) | 0x80));
+					run >>= 7;
+				}
+				out.push_back(static_cast<char>(run));
+				value = !value;
+			}
+		}
+
+		// Decodes runs written by encode_runs into 'cells', which must already
+		// have the tile's size. Returns false if the data is malformed.
+		inline bool decode_runs(const std::string& in, std::vector<bool>& cells) {
+			bool value = false;
+			std::size_t i = 0;
+			std::size_t pos = 0;
+			while (pos < in.size()) {
+				std::size_t run = 0;
+				int shift = 0;
+				unsigned char byte;
+				do {
+					if (pos == in.size())
+						return false;
+					byte = static_cast<unsigned char>(in[pos++]);
+					run |= std::size_t(byte & 0x7f) << shift;
+					shift += 7;
+				} while (byte & 0x80);
+
+				if (run > cells.size() - i)
+					return false;
+				std::fill(cells.begin() + i, cells.begin() + i + run, value);
+				i += run;
+				value = !value;
+			}
+			return i == cells.size();
+		}
+	}
+
+	// A grid graph split into square tiles that are stored run-length encoded
+	// on disk, one file per tile, and read on first access. At most
+	// 'cache_size' tiles are kept in memory; the least recently used tile is
+	// written back if it was modified and then dropped. When the search
+	// frontier gets within 'prefetch_margin' nodes of a tile border, the
+	// neighboring tile is read on a background thread and joins the cache like
+	// any other tile, so prefetched tiles count against 'cache_size' too.
+	//
+	// Copies share the same tile cache, so a tiled_grid_graph can be passed to
+	// astar by value.
+	class tiled_grid_graph {
+	public:
+		typedef grid_graph::cost_type cost_type;
+		typedef grid_graph::node node;
+		typedef grid_graph::node_hash node_hash;
+
+	public:
+		// Creates an empty map in 'directory', which must exist. Tiles that were
+		// never written are read as obstacle-free.
+		static void create(const std::string& directory, int col_count, int row_count, int tile_size) {
+			std::ofstream file((directory + "/grid").c_str());
+			file << col_count << " " << row_count << " " << tile_size << std::endl;
+			if (!file)
+				throw std::runtime_error("Can't write " + directory + "/grid");
+		}
+
+		tiled_grid_graph(const std::string& directory, std::size_t cache_size, int prefetch_margin = 2)
+			: _cache(new tile_cache(directory, cache_size, prefetch_margin)) {}
+
+		int row_count() const { return _cache->row_count; }
+		int col_count() const { return _cache->col_count; }
+		int tile_size() const { return _cache->tile_size; }
+
+		// Returns a vector of all empty nodes adjacent to n
+		std::vector<node> adjacent_nodes(const node& n) {
+			_cache->prefetch_around(n);
+
+			std::vector<node> nodes;
+			node new_node = n;
+
+			new_node.col -= 1;
+			if (!obstacle(new_node))
+				nodes.push_back(new_node);
+
+			new_node.col += 1;
+			new_node.row -= 1;
+			if (!obstacle(new_node))
+				nodes.push_back(new_node);
+
+			new_node.col += 1;
+			new_node.row += 1;
+			if (!obstacle(new_node))
+				nodes.push_back(new_node);
+
+			new_node.col -= 1;
+			new_node.row += 1;
+			if (!obstacle(new_node))
+				nodes.push_back(new_node);
+
+			return nodes;
+		}
+
+		// Returns the distance (cost) between two adjacent nodes
+		cost_type cost(const node& n1, const node& n2) const {
+			return std::abs(n2.col - n1.col) + std::abs(n2.row - n1.row);
+		}
+
+		// Sets or resets an obstacle. The tile is written back when it is evicted
+		// or on flush().
+		void obstacle(const node& n, bool obstacle) {
+			if (!_cache->contains(n))
+				return;
+			tile& t = _cache->acquire(_cache->tile_index(n));
+			t.cells[_cache->cell_index(n)] = obstacle;
+			t.dirty = true;
+		}
+
+		bool obstacle(const node& n) const {
+			// Pretend there are obstacles on every node outside the map
+			if (!_cache->contains(n))
+				return true;
+			return _cache->acquire(_cache->tile_index(n)).cells[_cache->cell_index(n)];
+		}
+
+		// Always true: telling whether two nodes are connected would require
+		// reading every tile between them
+		bool connected(const node&, const node&) const {
+			return true;
+		}
+
+		// Writes all modified tiles to disk
+		void flush() {
+			_cache->flush();
+		}
+
+		// Waits until the prefetcher has read every tile it was asked for
+		void wait_for_prefetches() {
+			_cache->wait_for_prefetches();
+		}
+
+		tile_cache_stats stats() const {
+			tile_cache_stats stats = _cache->stats;
+			boost::mutex::scoped_lock lock(_cache->mutex);
+			stats.prefetch_io_seconds = _cache->prefetch_io_seconds;
+			return stats;
+		}
+
+		void reset_stats() {
+			_cache->stats = tile_cache_stats();
+			boost::mutex::scoped_lock lock(_cache->mutex);
+			_cache->prefetch_io_seconds = 0;
+		}
+
+	private:
+		struct tile {
+			long index;
+			bool dirty;
+			bool prefetched; // read by the prefetcher and not used yet
+			std::vector<bool> cells;
+		};
+
+		typedef std::list<tile> tile_list;
+		typedef flat_hash_map<long, tile_list::iterator> tile_map;
+		typedef flat_hash_map<long, std::vector<bool> > ready_map;
+
+		// The cache proper. Only the thread using the graph touches the resident
+		// tiles and the stats; the prefetch queue, the tiles read by the
+		// prefetcher and the prefetcher's I/O time are guarded by 'mutex'.
+		class tile_cache {
+		public:
+			tile_cache(const std::string& directory, std::size_t cache_size, int prefetch_margin)
+				: directory(directory), capacity(std::max<std::size_t>(cache_size, 1)), prefetch_margin(prefetch_margin), last(), prefetch_io_seconds(0), stopping(false) {
+				std::ifstream file((directory + "/grid").c_str());
+				file >> col_count >> row_count >> tile_size;
+				if (!file || tile_size <= 0)
+					throw std::runtime_error("Can't read " + directory + "/grid");
+				tile_cols = (col_count + tile_size - 1) / tile_size;
+				tile_rows = (row_count + tile_size - 1) / tile_size;
+
+				if (prefetch_margin > 0)
+					loader = boost::thread(&tile_cache::load_in_background, this);
+			}
+
+			~tile_cache() {
+				{
+					boost::mutex::scoped_lock lock(mutex);
+					stopping = true;
+				}
+				queued.notify_all();
+				if (loader.joinable())
+					loader.join();
+
+				try {
+					flush();
+				} catch (const std::exception&) {
+					// Destructors can't report errors, call flush() to see them
+				}
+			}
+
+			bool contains(const node& n) const {
+				return n.col >= 0 && n.col < col_count && n.row >= 0 && n.row < row_count;
+			}
+
+			long tile_index(const node& n) const {
+				return long(n.row / tile_size) * tile_cols + n.col / tile_size;
+			}
+
+			std::size_t cell_index(const node& n) const {
+				return std::size_t(n.row % tile_size) * tile_size + n.col % tile_size;
+			}
+
+			tile& acquire(long index) {
+				if (last && last->index == index) {
+					stats.hits += 1;
+					return *last;
+				}
+
+				tile_map::iterator it = resident.find(index);
+				if (it == resident.end() && prefetch_margin > 0) {
+					double start = detail::seconds();
+					wait_for(index);
+					stats.io_seconds += detail::seconds() - start;
+					take_prefetched();
+					it = resident.find(index);
+				}
+
+				if (it != resident.end()) {
+					tiles.splice(tiles.begin(), tiles, it->second);
+					last = &tiles.front();
+					if (last->prefetched) {
+						last->prefetched = false;
+						stats.prefetch_hits += 1;
+					} else {
+						stats.hits += 1;
+					}
+					return *last;
+				}
+
+				std::vector<bool> cells;
+				double start = detail::seconds();
+				read(index, cells);
+				stats.io_seconds += detail::seconds() - start;
+				stats.misses += 1;
+
+				insert(index, cells, false);
+				last = &tiles.front();
+				return *last;
+			}
+
+			void prefetch_around(const node& n) {
+				if (prefetch_margin <= 0 || !contains(n))
+					return;
+				take_prefetched();
+
+				int col = n.col % tile_size;
+				int row = n.row % tile_size;
+				int tile_col = n.col / tile_size;
+				int tile_row = n.row / tile_size;
+				if (col < prefetch_margin)
+					prefetch(tile_col - 1, tile_row);
+				if (col >= tile_size - prefetch_margin)
+					prefetch(tile_col + 1, tile_row);
+				if (row < prefetch_margin)
+					prefetch(tile_col, tile_row - 1);
+				if (row >= tile_size - prefetch_margin)
+					prefetch(tile_col, tile_row + 1);
+			}
+
+			void wait_for_prefetches() {
+				boost::mutex::scoped_lock lock(mutex);
+				while (!in_flight.empty())
+					loaded.wait(lock);
+			}
+
+			void flush() {
+				for (tile_list::iterator it = tiles.begin(); it != tiles.end(); ++it) {
+					if (it->dirty) {
+						write(it->index, it->cells);
+						it->dirty = false;
+					}
+				}
+			}
+
+		private:
+			// Adds a tile in front of the LRU list, evicting the least recently
+			// used tiles beyond the capacity
+			void insert(long index, std::vector<bool>& cells, bool prefetched) {
+				tiles.push_front(tile());
+				tiles.front().index = index;
+				tiles.front().dirty = false;
+				tiles.front().prefetched = prefetched;
+				tiles.front().cells.swap(cells);
+				resident[index] = tiles.begin();
+
+				while (tiles.size() > capacity)
+					evict();
+			}
+
+			void evict() {
+				tile& t = tiles.back();
+				if (t.dirty)
+					write(t.index, t.cells);
+				if (last == &t)
+					last = 0;
+				resident.erase(t.index);
+				tiles.pop_back();
+				stats.evictions += 1;
+			}
+
+			void prefetch(int tile_col, int tile_row) {
+				if (tile_col < 0 || tile_col >= tile_cols || tile_row < 0 || tile_row >= tile_rows)
+					return;
+				long index = long(tile_row) * tile_cols + tile_col;
+				if (resident.count(index))
+					return;
+
+				std::size_t pending;
+				{
+					boost::mutex::scoped_lock lock(mutex);
+					if (in_flight.count(index) || ready.count(index))
+						return;
+					pending = in_flight.size() + ready.size() + 1;
+				}
+
+				// Tiles on their way in count against the capacity. Make room
+				// without holding the lock, evicting may write a tile, but never
+				// evict the tile in use.
+				while (tiles.size() > 1 && tiles.size() + pending > capacity)
+					evict();
+				if (tiles.size() + pending > capacity)
+					return;
+
+				boost::mutex::scoped_lock lock(mutex);
+				in_flight.insert(index);
+				queue.push_back(index);
+				queued.notify_one();
+			}
+
+			// Waits for the prefetcher if it's reading the tile
+			void wait_for(long index) {
+				boost::mutex::scoped_lock lock(mutex);
+				while (in_flight.count(index))
+					loaded.wait(lock);
+			}
+
+			// Moves the tiles read by the prefetcher into the LRU list, so that
+			// the ones that are never used age out like any other tile
+			void take_prefetched() {
+				ready_map taken;
+				{
+					boost::mutex::scoped_lock lock(mutex);
+					if (ready.empty())
+						return;
+					taken.swap(ready);
+				}
+
+				for (ready_map::iterator it = taken.begin(); it != taken.end(); ++it) {
+					if (!resident.count(it->first))
+						insert(it->first, it->second, true);
+				}
+			}
+
+			void load_in_background() {
+				for (;;) {
+					long index;
+					{
+						boost::mutex::scoped_lock lock(mutex);
+						while (queue.empty() && !stopping)
+							queued.wait(lock);
+						if (stopping)
+							return;
+						index = queue.front();
+						queue.pop_front();
+					}
+
+					double start = detail::seconds();
+					std::vector<bool> cells;
+					bool ok = true;
+					try {
+						read(index, cells);
+					} catch (const std::exception&) {
+						// Leave it to the on-demand read to report the error
+						ok = false;
+					}
+
+					boost::mutex::scoped_lock lock(mutex);
+					if (ok)
+						ready[index].swap(cells);
+					in_flight.erase(index);
+					prefetch_io_seconds += detail::seconds() - start;
+					loaded.notify_all();
+				}
+			}
+
+			std::string path(long index) const {
+				std::ostringstream os;
+				os << directory << "/" << index % tile_cols << "_" << index / tile_cols << ".tile";
+				return os.str();
+			}
+
+			void read(long index, std::vector<bool>& cells) const {
+				cells.assign(std::size_t(tile_size) * tile_size, false);
+
+				std::ifstream file(path(index).c_str(), std::ios::binary);
+				if (!file)
+					return; // never written, obstacle-free
+
+				std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+				if (!detail::decode_runs(data, cells))
+					throw std::runtime_error("Corrupt tile " + path(index));
+			}
+
+			void write(long index, const std::vector<bool>& cells) const {
+				std::string data;
+				detail::encode_runs(cells, data);
+
+				std::ofstream file(path(index).c_str(), std::ios::binary | std::ios::trunc);
+				file.write(data.data(), data.size());
+				if (!file)
+					throw std::runtime_error("Can't write " + path(index));
+			}
+
+		public:
+			std::string directory;
+			int col_count;
+			int row_count;
+			int tile_size;
+			int tile_cols;
+			int tile_rows;
+			std::size_t capacity;
+			int prefetch_margin;
+
+			tile_list tiles; // most recently used first
+			tile_map resident;
+			tile* last;
+			tile_cache_stats stats;
+
+			boost::mutex mutex;
+			boost::condition_variable queued;
+			boost::condition_variable loaded;
+			std::deque<long> queue;
+			flat_hash_set<long> in_flight;
+			ready_map ready;
+			double prefetch_io_seconds;
+			bool stopping;
+			boost::thread loader;
+		};
+
+	private:
+		boost::shared_ptr<tile_cache> _cache;
+	};
+}
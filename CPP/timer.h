@@ -0,0 +1,27 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#pragma once
+#include <sys/time.h>
+
+namespace ac {
+	namespace detail {
+		// Wall clock time in seconds
+		inline double seconds() {
+			timeval tv;
+			gettimeofday(&tv, 0);
+			return tv.tv_sec + tv.tv_usec * 1e-6;
+		}
+	}
+}
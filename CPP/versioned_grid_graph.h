@@ -0,0 +1,287 @@
+//  Copyright 2011 Alejandro Isaza.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+//  use this file except in compliance with the License.  You may obtain a copy
+//  of the License at
+// 
+//  http://www.apache.org/licenses/LICENSE-2.0
+// 
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+//  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+//  License for the specific language governing permissions and limitations under
+//  the License.
+
+#pragma once
+#include "grid_graph.h"
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ac {
+	// A grid graph that can be updated while other threads search it. Readers
+	// call read() to get an immutable snapshot, which follows the graph concept
+	// and can be passed to astar. Taking and reading a snapshot never locks.
+	//
+	// The grid is split into square tiles. An update copies the tiles it
+	// touches and publishes a new version that shares every other tile with
+	// the previous one. Writers are serialized by a mutex. Versions replaced
+	// by an update are retired and deleted once no snapshot taken before the
+	// update is alive (epoch-based reclamation). At most 'max_readers'
+	// snapshots can be alive at once.
+	class versioned_grid_graph {
+	public:
+		typedef grid_graph::cost_type cost_type;
+		typedef grid_graph::node node;
+		typedef grid_graph::node_hash node_hash;
+
+	private:
+		struct tile {
+			std::vector<bool> cells;
+		};
+
+		struct version {
+			boost::uint64_t number;
+			std::vector<boost::shared_ptr<const tile> > tiles; // null tiles are obstacle-free
+		};
+
+		// Each alive snapshot announces the epoch it started in, 0 means free.
+		// Slots are padded to avoid false sharing between reader threads.
+		struct reader_slot {
+			boost::atomic<boost::uint64_t> epoch;
+			char padding[64 - sizeof(boost::atomic<boost::uint64_t>)];
+			reader_slot() : epoch(0) {}
+		};
+
+		struct state {
+			int col_count;
+			int row_count;
+			int tile_size;
+			int tile_cols;
+
+			boost::atomic<version*> current;
+			boost::atomic<boost::uint64_t> epoch;
+			boost::scoped_array<reader_slot> slots;
+			std::size_t slot_count;
+
+			boost::mutex write_mutex;
+			std::vector<std::pair<boost::uint64_t, version*> > retired;
+
+			state() : current(0), epoch(1) {}
+
+			~state() {
+				delete current.load();
+				for (std::size_t i = 0; i < retired.size(); i += 1)
+					delete retired[i].second;
+			}
+
+			bool contains(const node& n) const {
+				return n.col >= 0 && n.col < col_count && n.row >= 0 && n.row < row_count;
+			}
+
+			std::size_t tile_index(const node& n) const {
+				return std::size_t(n.row / tile_size) * tile_cols + n.col / tile_size;
+			}
+
+			std::size_t cell_index(const node& n) const {
+				return std::size_t(n.row % tile_size) * tile_size + n.col % tile_size;
+			}
+		};
+
+		// Releases the reader slot when the last copy of a snapshot goes away
+		struct reader {
+			boost::shared_ptr<state> grid;
+			reader_slot* slot;
+			~reader() { slot->epoch.store(0); }
+		};
+
+	public:
+		// An immutable view of the grid at the time read() was called
+		class snapshot {
+		public:
+			typedef versioned_grid_graph::cost_type cost_type;
+			typedef versioned_grid_graph::node node;
+			typedef versioned_grid_graph::node_hash node_hash;
+
+		public:
+			int row_count() const { return _grid->row_count; }
+			int col_count() const { return _grid->col_count; }
+
+			// The number of updates applied to the grid before this snapshot was taken
+			boost::uint64_t version_number() const { return _version->number; }
+
+			// Returns a vector of all empty nodes adjacent to n
+			std::vector<node> adjacent_nodes(const node& n) const {
+				std::vector<node> nodes;
+				node new_node = n;
+
+				new_node.col -= 1;
+				if (!obstacle(new_node))
+					nodes.push_back(new_node);
+
+				new_node.col += 1;
+				new_node.row -= 1;
+				if (!obstacle(new_node))
+					nodes.push_back(new_node);
+
+				new_node.col += 1;
+				new_node.row += 1;
+				if (!obstacle(new_node))
+					nodes.push_back(new_node);
+
+				new_node.col -= 1;
+				new_node.row += 1;
+				if (!obstacle(new_node))
+					nodes.push_back(new_node);
+
+				return nodes;
+			}
+
+			// Returns the distance (cost) between two adjacent nodes
+			cost_type cost(const node& n1, const node& n2) const {
+				return std::abs(n2.col - n1.col) + std::abs(n2.row - n1.row);
+			}
+
+			bool obstacle(const node& n) const {
+				// Pretend there are obstacles on every node outside the specified width and height
+				if (!_grid->contains(n))
+					return true;
+
+				const tile* t = _version->tiles[_grid->tile_index(n)].get();
+				return t && t->cells[_grid->cell_index(n)];
+			}
+
+			// Always true, snapshots don't keep connected components
+			bool connected(const node&, const node&) const {
+				return true;
+			}
+
+		private:
+			friend class versioned_grid_graph;
+			snapshot(const boost::shared_ptr<reader>& r, const version* v) : _reader(r), _grid(r->grid.get()), _version(v) {}
+
+			boost::shared_ptr<reader> _reader;
+			const state* _grid;
+			const version* _version;
+		};
+
+	public:
+		versioned_grid_graph(int col_count, int row_count, int tile_size = 64, std::size_t max_readers = 64) : _state(new state) {
+			_state->col_count = col_count;
+			_state->row_count = row_count;
+			_state->tile_size = tile_size;
+			_state->tile_cols = (col_count + tile_size - 1) / tile_size;
+			_state->slots.reset(new reader_slot[max_readers]);
+			_state->slot_count = max_readers;
+
+			int tile_rows = (row_count + tile_size - 1) / tile_size;
+			version* v = new version;
+			v->number = 0;
+			v->tiles.resize(std::size_t(_state->tile_cols) * tile_rows);
+			_state->current.store(v);
+		}
+
+		int row_count() const { return _state->row_count; }
+		int col_count() const { return _state->col_count; }
+
+		// Takes a snapshot of the current version. Safe to call from any thread.
+		snapshot read() const {
+			reader_slot* slot = claim_slot();
+			boost::shared_ptr<reader> r(new reader);
+			r->grid = _state;
+			r->slot = slot;
+			return snapshot(r, _state->current.load());
+		}
+
+		// Sets or resets an obstacle and publishes a new version
+		void obstacle(const node& n, bool obstacle) {
+			obstacles(std::vector<node>(1, n), obstacle);
+		}
+
+		// Sets or resets several obstacles in a single new version
+		void obstacles(const std::vector<node>& nodes, bool obstacle) {
+			state& s = *_state;
+			boost::mutex::scoped_lock lock(s.write_mutex);
+
+			version* old_version = s.current.load();
+			version* new_version = new version(*old_version);
+			new_version->number = old_version->number + 1;
+
+			// Tiles copied for this version, by tile index
+			std::vector<std::pair<std::size_t, tile*> > copied;
+			for (std::size_t i = 0; i < nodes.size(); i += 1) {
+				if (!s.contains(nodes[i]))
+					continue;
+
+				std::size_t index = s.tile_index(nodes[i]);
+				tile* t = 0;
+				for (std::size_t j = 0; j < copied.size() && !t; j += 1) {
+					if (copied[j].first == index)
+						t = copied[j].second;
+				}
+				if (!t) {
+					t = new tile;
+					if (new_version->tiles[index])
+						t->cells = new_version->tiles[index]->cells;
+					else
+						t->cells.assign(std::size_t(s.tile_size) * s.tile_size, false);
+					new_version->tiles[index].reset(t);
+					copied.push_back(std::make_pair(index, t));
+				}
+				t->cells[s.cell_index(nodes[i])] = obstacle;
+			}
+
+			// Publish before advancing the epoch: a reader that sees the new
+			// epoch is guaranteed to see the new version.
+			s.current.store(new_version);
+			s.retired.push_back(std::make_pair(s.epoch.fetch_add(1), old_version));
+			reclaim();
+		}
+
+		// The number of replaced versions that are still waiting for readers
+		std::size_t retired_count() const {
+			boost::mutex::scoped_lock lock(_state->write_mutex);
+			return _state->retired.size();
+		}
+
+	private:
+		reader_slot* claim_slot() const {
+			state& s = *_state;
+			for (std::size_t i = 0; i < s.slot_count; i += 1) {
+				boost::uint64_t free = 0;
+				if (s.slots[i].epoch.load() == 0 && s.slots[i].epoch.compare_exchange_strong(free, s.epoch.load()))
+					return &s.slots[i];
+			}
+			throw std::runtime_error("Too many concurrent versioned_grid_graph snapshots");
+		}
+
+		// Deletes the retired versions that no alive snapshot can be reading.
+		// Must be called with the write mutex held.
+		void reclaim() {
+			state& s = *_state;
+			boost::uint64_t oldest = s.epoch.load();
+			for (std::size_t i = 0; i < s.slot_count; i += 1) {
+				boost::uint64_t e = s.slots[i].epoch.load();
+				if (e != 0 && e < oldest)
+					oldest = e;
+			}
+
+			std::size_t kept = 0;
+			for (std::size_t i = 0; i < s.retired.size(); i += 1) {
+				if (s.retired[i].first < oldest)
+					delete s.retired[i].second;
+				else
+					s.retired[kept++] = s.retired[i];
+			}
+			s.retired.resize(kept);
+		}
+
+	private:
+		boost::shared_ptr<state> _state;
+	};
+}